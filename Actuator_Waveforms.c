@@ -17,7 +17,8 @@
  * 		"effect_data". Where "effect" is the name of the
  * 		waveform. The first value in the pair is the
  * 		amplitude and the second value is the time. Each
- * 		unit of time is ~5ms.
+ * 		unit of time is HAPTICS_TICK_US (5.405ms) at any
+ * 		clock frequency.
  * 		waveform[] = {
  * 			amplitude,time,
  * 			amplitude,time,
@@ -29,156 +30,221 @@
  * 3. The Waveform structure should be set to:
  * 		Waveform effect = {
  * 			mode, 	// LRA_AUTOON, LRA_AUTOOFF, or ERM
- * 			length, // size in bytes of "effect_data"
+ * 			length, // sizeof(effect_data), never a typed number
  * 			data	// name of the data array "effect_data"
  * 		};
  *
  *	  LRA_AUTOON - LRA with auto-resonance ON
  *	  LRA_AUTOFF - LRA waveform with auto-resonance OFF
  *	  ERM - ERM waveform
+ *
+ * 4. Ramps: add HAPTICS_SEGMENTS to the mode and write a ramp as three bytes
+ * 		amplitude, 0x00, ticks
+ * 		The player moves linearly from the current amplitude to "amplitude"
+ * 		over "ticks" (1-255) time units.  A waveform starts from 0x80 (no drive).
+ * 		Plain (amplitude, time) pairs with a time > 0 work as before.
+ *
+ *	  The player scales the drive (amplitude - 0x80) by Haptics_SetIntensity
+ *	  and Haptics_SetActuatorIntensity and clamps it to the mode maximum, so
+ *	  write amplitudes for full intensity and do not copy a table to change it.
+ *
+ * 5. Overdrive and braking: describe the effect as an intensity envelope in
+ * 		tools/haptics_effects.json and run
+ * 		python3 tools/haptics_prep.py tools/haptics_effects.json --update Actuator_Waveforms.c
+ * 		The tool adds the full drive and reverse drive kicks that make the
+ * 		actuator start and stop quickly.  The click tables below with a
+ * 		"tau" comment are generated this way, edit the envelope rather than
+ * 		the data.  Without --update the tables are printed.  Effects can
+ * 		also be written as hold/ramp/loop steps in ms in the same file, the
+ * 		tool checks the levels, durations and flash use of every effect.
+ *
+ * 6. Envelopes: instead of a data array create an Envelope
+ * 		Envelope effect_envelope = {
+ * 			attack, decay, sustain, release,	// ticks of each stage
+ * 			peak, level,						// amplitudes
+ * 			repeat, gap							// times to play, ticks between
+ * 		};
+ * 		Waveform effect = {mode+HAPTICS_ENVELOPE, sizeof(Envelope),
+ * 			(const unsigned char*) &effect_envelope};
+ * 		The player computes the ramps while it plays, so an envelope in RAM can
+ * 		be tuned live (see the 'e' command in main.c).
+ *
+ * 7. Add an EFFECT_ ID at the end of the enum in Actuator_Waveforms.h and the
+ * 		effect at the same position in Waveforms_effects at the end of this
+ * 		file.  Play it with Haptics_SendEffect(EFFECT_...) or "p id" on the UART.
+ *
+ * 8. Repeats and shared segments: in HAPTICS_SEGMENTS data
+ * 		HAPTICS_LOOP(count, bytes)	plays the next "bytes" bytes "count" times
+ * 		HAPTICS_CALL(SEGMENT_...)	plays a segment of Waveforms_segments
+ * 		A click train is one loop around one click, and effects built from the
+ * 		same clicks call one copy of the click.  Add a segment like an effect
+ * 		(SEGMENT_ ID at the end of the enum, data below).  The player follows
+ * 		the loop and the call as it plays, there is no decode buffer: one loop
+ * 		at a time, and a segment may loop but not call.  The "tau" tables
+ * 		are rewritten by haptics_prep.py --update, so they stay plain data.
  ******************************************************************************/
 
 #include "Actuator_Waveforms.h"
+#include "WaveformStore.h"
+
+//--------------------------------------------------------//
+// Shared Segments, indexed by the SEGMENT_* IDs
+//--------------------------------------------------------//
+static const unsigned char lra_click_segment[] = {
+		LRA_AUTOON_MAX, 0x08,
+		0x00, 0x09};
+
+static const unsigned char lra_click_nobrake_segment[] = {
+		LRA_AUTOON_MAX, 0x0D,
+		0x80, 0x09};
+
+static const unsigned char lra_click_long_segment[] = {
+		LRA_AUTOON_MAX, 0x0C,
+		0x00, 0x09};
+
+static const unsigned char erm_bump_segment[] = {
+		0xFF, 0x05,
+		0xB4, 0x08};
+
+const Segment Waveforms_segments[SEGMENT_COUNT] = {
+		{sizeof(lra_click_segment),lra_click_segment},
+		{sizeof(lra_click_nobrake_segment),lra_click_nobrake_segment},
+		{sizeof(lra_click_long_segment),lra_click_long_segment},
+		{sizeof(erm_bump_segment),erm_bump_segment}
+};
 
 //--------------------------------------------------------//
 //LRA Standard Effects
 //--------------------------------------------------------//
+// lra, tau 20.6 ms: rise never (plain never), stop 36 ms (plain 68 ms)
 const unsigned char lra_click_data[] = {
 		LRA_AUTOON_MAX, 0x05,
-		0x00, 0x07};
-const Waveform lra_click = {LRA_AUTOON,4,lra_click_data};
+		0x00, 0x02,
+		0x80, 0x01};
+const Waveform lra_click = {LRA_AUTOON,sizeof(lra_click_data),lra_click_data};
 
 const unsigned char lra_click_nobrake_data[] = {
 		LRA_AUTOON_MAX, 0x0A,
 		0x80, 0x02};
-const Waveform lra_click_nobrake = {LRA_AUTOON,4,lra_click_nobrake_data};
+const Waveform lra_click_nobrake = {LRA_AUTOON,sizeof(lra_click_nobrake_data),lra_click_nobrake_data};
 
+// lra, tau 20.6 ms: rise never (plain never), stop 148 ms (plain 180 ms)
 const unsigned char lra_doubleclick_data[] = {
 		LRA_AUTOON_MAX, 0x08,
-		0x00, 0x09,
+		0x00, 0x02,
+		0x80, 0x07,
 		LRA_AUTOON_MAX, 0x08,
-		0x00, 0x09};
-const Waveform lra_doubleclick = {LRA_AUTOON,8,lra_doubleclick_data};
+		0x00, 0x02,
+		0x80, 0x01};
+const Waveform lra_doubleclick = {LRA_AUTOON,sizeof(lra_doubleclick_data),lra_doubleclick_data};
 
 const unsigned char lra_doubleclick_nobrake_data[] = {
-		LRA_AUTOON_MAX, 0x0D,
-		0x80, 0x09,
-		LRA_AUTOON_MAX, 0x0D,
-		0x80, 0x09};
-const Waveform lra_doubleclick_nobrake = {LRA_AUTOON,8,lra_doubleclick_nobrake_data};
+		HAPTICS_LOOP(2, 3),
+		HAPTICS_CALL(SEGMENT_LRA_CLICK_NOBRAKE)};
+const Waveform lra_doubleclick_nobrake = {LRA_AUTOON+HAPTICS_SEGMENTS,sizeof(lra_doubleclick_nobrake_data),lra_doubleclick_nobrake_data};
 
 const unsigned char lra_alert_data[] = {
 		LRA_AUTOON_MAX, 0x85};
-const Waveform lra_alert = {LRA_AUTOON,2,lra_alert_data};
+const Waveform lra_alert = {LRA_AUTOON,sizeof(lra_alert_data),lra_alert_data};
 
 const unsigned char lra_rampup_data[] = {
 		0xFF, 0x02,
-		0x90, 0x15,
-		0xA0, 0x15,
-		0xB0, 0x10,
-		0xD0, 0x09,
+		0x90, 0x01,
+		LRA_AUTOON_MAX, 0x00, 0x42,
 		LRA_AUTOON_MAX, 0x05,
 		0x00, 0x03
 };
-const Waveform lra_rampup = {LRA_AUTOON,14,lra_rampup_data};
+const Waveform lra_rampup = {LRA_AUTOON+HAPTICS_SEGMENTS,sizeof(lra_rampup_data),lra_rampup_data};
 
 const unsigned char lra_rampdown_data[] = {
 		LRA_AUTOON_MAX, 0x06,
-		0xD0, 0x09,
-		0xB0, 0x10,
-		0xA0, 0x15,
-		0x90, 0x15,
+		0x90, 0x00, 0x43,
 		0x00, 0x08
 };
-const Waveform lra_rampdown = {LRA_AUTOON,12,lra_rampdown_data};
+const Waveform lra_rampdown = {LRA_AUTOON+HAPTICS_SEGMENTS,sizeof(lra_rampdown_data),lra_rampdown_data};
 
 //--------------------------------------------------------//
 //LRA Standard Effects in Dumb Mode
-//Note: Using ERM mode to emulate dumb drive, so it must be scaled for 2Vrms
+//Note: Using ERM mode to emulate dumb drive, the player clamps the amplitude to
+//LRA_AUTOOFF_MAX (2Vrms) before scaling, so effects with the same timing share
+//the LRA data
 //--------------------------------------------------------//
+// lra_dumb, tau 20.6 ms: rise 47 ms (plain 47 ms), stop 77 ms (plain 111 ms)
 const unsigned char lra_click_dumb_data[] = {
 		LRA_AUTOOFF_MAX, 0x0C,
-		0x1A, 0x09};
-const Waveform lra_click_dumb = {LRA_AUTOOFF, 4,lra_click_dumb_data};
+		0x1A, 0x03,
+		0x80, 0x01};
+const Waveform lra_click_dumb = {LRA_AUTOOFF,sizeof(lra_click_dumb_data),lra_click_dumb_data};
 
-const unsigned char lra_click_nobrake_dumb_data[] = {
-		LRA_AUTOOFF_MAX, 0x0D,
-		0x80, 0x09};
-const Waveform lra_click_nobrake_dumb = {LRA_AUTOOFF,4,lra_click_nobrake_dumb_data};
+const Waveform lra_click_nobrake_dumb = {LRA_AUTOOFF,sizeof(lra_click_nobrake_segment),lra_click_nobrake_segment};
 
+// lra_dumb, tau 20.6 ms: rise 47 ms (plain 47 ms), stop 190 ms (plain 225 ms)
 const unsigned char lra_doubleclick_dumb_data[] = {
 		LRA_AUTOOFF_MAX, 0x0C,
-		0x1A, 0x09,
+		0x1A, 0x03,
+		0x80, 0x06,
 		LRA_AUTOOFF_MAX, 0x0C,
-		0x1A, 0x09};
-const Waveform lra_doubleclick_dumb = {LRA_AUTOOFF,8,lra_doubleclick_dumb_data};
+		0x1A, 0x03,
+		0x80, 0x01};
+const Waveform lra_doubleclick_dumb = {LRA_AUTOOFF,sizeof(lra_doubleclick_dumb_data),lra_doubleclick_dumb_data};
 
-const unsigned char lra_doubleclick_nobrake_dumb_data[] = {
-		LRA_AUTOOFF_MAX, 0x0D,
-		0x80, 0x09,
-		LRA_AUTOOFF_MAX, 0x0D,
-		0x80, 0x09};
-const Waveform lra_doubleclick_nobrake_dumb = {LRA_AUTOOFF,8,lra_doubleclick_nobrake_dumb_data};
+const Waveform lra_doubleclick_nobrake_dumb = {LRA_AUTOOFF+HAPTICS_SEGMENTS,sizeof(lra_doubleclick_nobrake_data),lra_doubleclick_nobrake_data};
 
-const unsigned char lra_alert_dumb_data[] = {
-		LRA_AUTOOFF_MAX, 0x85};
-const Waveform lra_alert_dumb = {LRA_AUTOOFF,2,lra_alert_dumb_data};
+const Waveform lra_alert_dumb = {LRA_AUTOOFF,sizeof(lra_alert_data),lra_alert_data};
 
 //--------------------------------------------------------//
 //ERM Standard Effects
 //--------------------------------------------------------//
+// erm, tau 45.0 ms: rise never (plain never), stop 54 ms (plain 116 ms)
 const unsigned char erm_click_data[] = {
 		0xFF, 0x07,
-		0x00, 0x04};
-const Waveform erm_click = {ERM,4,erm_click_data};
+		0x00, 0x04,
+		0x80, 0x01};
+const Waveform erm_click = {ERM,sizeof(erm_click_data),erm_click_data};
 
 const unsigned char erm_bump_data[] = {
 		0xFF, 0x05,
 		0xB4, 0x07};
-const Waveform erm_bump = {ERM,4,erm_bump_data};
+const Waveform erm_bump = {ERM,sizeof(erm_bump_data),erm_bump_data};
 
+// erm, tau 45.0 ms: rise 20 ms (plain never), stop 203 ms (plain 279 ms)
 const unsigned char erm_doubleclick_data[] = {
-		0xFF, 0x06,
-		0xB4, 0x03,
-		0x00, 0x04,
-		0x80, 0x0C,
-		0xFF, 0x07,
-		0xB4, 0x03,
-		0x00, 0x05};
-const Waveform erm_doubleclick = {ERM,14,erm_doubleclick_data};
+		0xFF, 0x04,
+		0xB3, 0x05,
+		0x00, 0x03,
+		0x80, 0x0D,
+		0xFF, 0x04,
+		0xB3, 0x06,
+		0x00, 0x03,
+		0x80, 0x01};
+const Waveform erm_doubleclick = {ERM,sizeof(erm_doubleclick_data),erm_doubleclick_data};
 
 const unsigned char erm_doublebump_data[] = {
-		0xFF, 0x05,
-		0xB4, 0x08,
+		HAPTICS_CALL(SEGMENT_ERM_BUMP),
 		0x80, 0x0C,
-		0xFF, 0x05,
-		0xB4, 0x08};
-const Waveform erm_doublebump = {ERM,10,erm_doublebump_data};
+		HAPTICS_CALL(SEGMENT_ERM_BUMP)};
+const Waveform erm_doublebump = {ERM+HAPTICS_SEGMENTS,sizeof(erm_doublebump_data),erm_doublebump_data};
 
 const unsigned char erm_alert_data[] = {
 		0xFF, 0x03,
 		0xB4, 0x60};
-const Waveform erm_alert = {ERM,4,erm_alert_data};
+const Waveform erm_alert = {ERM,sizeof(erm_alert_data),erm_alert_data};
 
 const unsigned char erm_rampup_data[] = {
-		0x90, 0x15,
-		0xA0, 0x15,
-		0xB0, 0x09,
-		0xC0, 0x05,
+		0x90, 0x01,
+		0xC0, 0x00, 0x37,
 		0xFF, 0x04,
 		0x00, 0x04
 };
-const Waveform erm_rampup = {ERM,12,erm_rampup_data};
+const Waveform erm_rampup = {ERM+HAPTICS_SEGMENTS,sizeof(erm_rampup_data),erm_rampup_data};
 
 const unsigned char erm_rampdown_data[] = {
 		0xFF, 0x04,
-		0xC0, 0x09,
-		0xB0, 0x10,
-		0xA0, 0x15,
-		0x90, 0x15,
+		0xC0, 0x01,
+		0x90, 0x00, 0x42,
 		0x00, 0x02
 };
-const Waveform erm_rampdown = {ERM,12,erm_rampdown_data};
+const Waveform erm_rampdown = {ERM+HAPTICS_SEGMENTS,sizeof(erm_rampdown_data),erm_rampdown_data};
 
 //--------------------------------------------------------//
 //Subtle LRA Effects
@@ -186,38 +252,35 @@ const Waveform erm_rampdown = {ERM,12,erm_rampdown_data};
 const unsigned char lra_tick_data[] = {
 		0xFF, 0x02,
 		0x00, 0x02};
-const Waveform lra_tick = {LRA_AUTOON,4,lra_tick_data};
+const Waveform lra_tick = {LRA_AUTOON,sizeof(lra_tick_data),lra_tick_data};
 
 const unsigned char lra_softclick_data[] = {
 		0xC0, 0x06,
 		0x00, 0x07};
-const Waveform lra_softclick = {LRA_AUTOON,4,lra_softclick_data};
+const Waveform lra_softclick = {LRA_AUTOON,sizeof(lra_softclick_data),lra_softclick_data};
 
 const unsigned char lra_softbump_data[] = {
 		0xC0, 0x05,
 		0xA0, 0x07};
-const Waveform lra_softbump = {LRA_AUTOON,4,lra_softbump_data};
+const Waveform lra_softbump = {LRA_AUTOON,sizeof(lra_softbump_data),lra_softbump_data};
 
 const unsigned char lra_softalert_data[] = {
 		0xB0, 0x80};
-const Waveform lra_softalert = {LRA_AUTOON,2,lra_softalert_data};
+const Waveform lra_softalert = {LRA_AUTOON,sizeof(lra_softalert_data),lra_softalert_data};
 
 //--------------------------------------------------------//
 // Simon LRA Effects
 //--------------------------------------------------------//
 const unsigned char lra_rampupdoubleclick_data[] = {
 		LRA_AUTOON_MAX, 0x02,
-		0x90, 0x40,
-		0xA0, 0x40,
-		0xB0, 0x30,
-		0xD0, 0x20,
-		0x00, 0x09,
-		LRA_AUTOON_MAX, 0x08,
+		0x90, 0x01,
+		0xD0, 0x00, 0xCF,
 		0x00, 0x09,
+		HAPTICS_CALL(SEGMENT_LRA_CLICK),
 		LRA_AUTOON_MAX, 0x09,
 		0x00, 0x09
 };
-const Waveform lra_rampupdoubleclick = {LRA_AUTOON,20,lra_rampupdoubleclick_data};
+const Waveform lra_rampupdoubleclick = {LRA_AUTOON+HAPTICS_SEGMENTS,sizeof(lra_rampupdoubleclick_data),lra_rampupdoubleclick_data};
 
 const unsigned char lra_threeclicks_data[] = {
 		LRA_AUTOON_MAX, 0x02,
@@ -227,9 +290,69 @@ const unsigned char lra_threeclicks_data[] = {
 		0x00, 0x09,
 		LRA_AUTOON_MAX, 0x0F,
 		0x00, 0x09,
-		LRA_AUTOON_MAX, 0x0C,
-		0x00, 0x09,
-		LRA_AUTOON_MAX, 0x0C,
-		0x00, 0x09
+		HAPTICS_CALL(SEGMENT_LRA_CLICK_LONG),
+		HAPTICS_CALL(SEGMENT_LRA_CLICK_LONG)
+};
+const Waveform lra_threeclicks = {LRA_AUTOON+HAPTICS_SEGMENTS,sizeof(lra_threeclicks_data),lra_threeclicks_data};
+
+//--------------------------------------------------------//
+// Envelope Effects
+//--------------------------------------------------------//
+static const Envelope lra_pulses_envelope = {
+		0x02, 0x03, 0x06, 0x04,
+		LRA_AUTOON_MAX, 0xC0,
+		0x03, 0x0A};
+const Waveform lra_pulses = {LRA_AUTOON+HAPTICS_ENVELOPE,sizeof(Envelope),(const unsigned char*) &lra_pulses_envelope};
+
+static const Envelope erm_swell_envelope = {
+		0x20, 0x00, 0x10, 0x30,
+		0xFF, 0xFF,
+		0x01, 0x00};
+const Waveform erm_swell = {ERM+HAPTICS_ENVELOPE,sizeof(Envelope),(const unsigned char*) &erm_swell_envelope};
+
+//--------------------------------------------------------//
+// Effect Registry, indexed by the EFFECT_* IDs
+//--------------------------------------------------------//
+const Waveform* const Waveforms_effects[EFFECT_COUNT] = {
+		&lra_click,
+		&lra_click_nobrake,
+		&lra_doubleclick,
+		&lra_doubleclick_nobrake,
+		&lra_alert,
+		&lra_rampup,
+		&lra_rampdown,
+		&lra_click_dumb,
+		&lra_click_nobrake_dumb,
+		&lra_doubleclick_dumb,
+		&lra_doubleclick_nobrake_dumb,
+		&lra_alert_dumb,
+		&erm_click,
+		&erm_bump,
+		&erm_doubleclick,
+		&erm_doublebump,
+		&erm_alert,
+		&erm_rampup,
+		&erm_rampdown,
+		&lra_tick,
+		&lra_softclick,
+		&lra_softbump,
+		&lra_softalert,
+		&lra_rampupdoubleclick,
+		&lra_threeclicks,
+		&lra_pulses,
+		&erm_swell
 };
-const Waveform lra_threeclicks = {LRA_AUTOON,22,lra_threeclicks_data};
+
+/**
+ * Waveforms_Find - look up an effect by ID
+ * @param uint8_t id - EFFECT_* ID, or EFFECT_USER and above for a stored waveform
+ * @return const Waveform* - the waveform, 0 if the ID is unknown
+ */
+const Waveform* Waveforms_Find(uint8_t id)
+{
+	if(id < EFFECT_COUNT)
+		return Waveforms_effects[id];
+	if(id >= EFFECT_USER)
+		return WaveformStore_Find(id);
+	return 0;
+}
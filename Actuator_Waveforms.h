@@ -12,10 +12,65 @@
  *
  ******************************************************************************/
 
-#include "Haptics.h"
+#ifndef ACTUATOR_WAVEFORMS_H_
+#define ACTUATOR_WAVEFORMS_H_
 
-#define LRA_AUTOON_MAX	 	0xF0 	// Set the maximum amplitude for auto-resonance ON mode
-#define LRA_AUTOOFF_MAX		0xD8 	//0xE6	// Set the maximum amplitude for auto-resonance OFF mode
+#include "Haptics.h"		// LRA_AUTOON_MAX, LRA_AUTOOFF_MAX
+
+// Effect IDs, the index in Waveforms_effects.  The IDs are used by the UART
+// commands and mode tables, append new effects at the end.
+enum Waveforms_EffectId {
+	EFFECT_LRA_CLICK = 0,
+	EFFECT_LRA_CLICK_NOBRAKE,
+	EFFECT_LRA_DOUBLECLICK,
+	EFFECT_LRA_DOUBLECLICK_NOBRAKE,
+	EFFECT_LRA_ALERT,
+	EFFECT_LRA_RAMPUP,
+	EFFECT_LRA_RAMPDOWN,
+	EFFECT_LRA_CLICK_DUMB,
+	EFFECT_LRA_CLICK_NOBRAKE_DUMB,
+	EFFECT_LRA_DOUBLECLICK_DUMB,
+	EFFECT_LRA_DOUBLECLICK_NOBRAKE_DUMB,
+	EFFECT_LRA_ALERT_DUMB,
+	EFFECT_ERM_CLICK,
+	EFFECT_ERM_BUMP,
+	EFFECT_ERM_DOUBLECLICK,
+	EFFECT_ERM_DOUBLEBUMP,
+	EFFECT_ERM_ALERT,
+	EFFECT_ERM_RAMPUP,
+	EFFECT_ERM_RAMPDOWN,
+	EFFECT_LRA_TICK,
+	EFFECT_LRA_SOFTCLICK,
+	EFFECT_LRA_SOFTBUMP,
+	EFFECT_LRA_SOFTALERT,
+	EFFECT_LRA_RAMPUPDOUBLECLICK,
+	EFFECT_LRA_THREECLICKS,
+	EFFECT_LRA_PULSES,
+	EFFECT_ERM_SWELL,
+	EFFECT_COUNT
+};
+
+#define EFFECT_USER		0x80		// IDs 0x80-0xFE are waveforms in the waveform store
+
+// Shared segment IDs, the index in Waveforms_segments (see HAPTICS_CALL).
+// Stored waveforms can call them, append new segments at the end.
+enum Waveforms_SegmentId {
+	SEGMENT_LRA_CLICK = 0,
+	SEGMENT_LRA_CLICK_NOBRAKE,
+	SEGMENT_LRA_CLICK_LONG,
+	SEGMENT_ERM_BUMP,
+	SEGMENT_COUNT
+};
+
+extern const Waveform* const Waveforms_effects[EFFECT_COUNT];
+extern const Segment Waveforms_segments[SEGMENT_COUNT];
+
+/**
+ * Waveforms_Find - look up an effect by ID
+ * @param uint8_t id - EFFECT_* ID, or EFFECT_USER and above for a stored waveform
+ * @return const Waveform* - the waveform, 0 if the ID is unknown
+ */
+const Waveform* Waveforms_Find(uint8_t id);
 
 //--------------------------------------------------------//
 //LRA Standard Effects
@@ -30,7 +85,7 @@ extern const Waveform lra_rampdown;
 
 //--------------------------------------------------------//
 //LRA Standard Effects in Dumb Mode
-//Note: Using ERM mode to emulate dumb drive, so it must be scaled for 2Vrms
+//Note: Using ERM mode to emulate dumb drive, the player clamps to LRA_AUTOOFF_MAX (2Vrms)
 //--------------------------------------------------------//
 extern const Waveform lra_click_dumb;
 extern const Waveform lra_click_nobrake_dumb;
@@ -62,3 +117,11 @@ extern const Waveform lra_softalert;
 //--------------------------------------------------------//
 extern const Waveform lra_rampupdoubleclick;
 extern const Waveform lra_threeclicks;
+
+//--------------------------------------------------------//
+//Envelope Effects
+//--------------------------------------------------------//
+extern const Waveform lra_pulses;
+extern const Waveform erm_swell;
+
+#endif /* ACTUATOR_WAVEFORMS_H_ */
@@ -19,6 +19,120 @@
 struct Element* modePtr;
 struct Element* buttonPtr;
 
+// Life test waveforms.  Buttons 3 and 4 step an intensity of the mode, the
+// actuator intensity is only set to it while these play (BinaryModes_PlayAt).
+static const unsigned char lra_lifetestclick_data[] = {
+		0xD3, (0x05 * 0x08),
+		0x00, (0x07 * 0x08)};
+static const Waveform lra_lifetestclick = {LRA_AUTOON,sizeof(lra_lifetestclick_data),lra_lifetestclick_data};
+
+static const unsigned char lra_testclick_data[] = {
+		0xD3, 0x05,
+		0x00, 0x07};
+static const Waveform lra_testclick = {LRA_AUTOON,sizeof(lra_testclick_data),lra_testclick_data};
+
+static const unsigned char lra_onofflifetest_data[] = {
+		0xD3, 0xFF,
+		0xD3, 0x90,
+		0x80, 0xC8};
+static const Waveform lra_onofflifetest = {LRA_AUTOON,sizeof(lra_onofflifetest_data),lra_onofflifetest_data};
+
+static const unsigned char lra_on_data[] = {
+		0xD3, 0xFF};
+static const Waveform lra_on = {LRA_AUTOON,sizeof(lra_on_data),lra_on_data};
+
+static const unsigned char erm_testclick_data[] = {
+		0xE0, 0x05,
+		0x00, 0x07};
+static const Waveform erm_testclick = {ERM,sizeof(erm_testclick_data),erm_testclick_data};
+
+static const unsigned char erm_on_data[] = {
+		0xE0, 0xFF};
+static const Waveform erm_on = {ERM,sizeof(erm_on_data),erm_on_data};
+
+// Mode 11 scroll trains, timer counts from the end of an effect to the next
+static const uint16_t scrollTicks1[] = {
+		100, 100, 100, SCROLL - 200, SCROLL - 200, SCROLL - 200,
+		SCROLL - 200, SCROLL - 200, SCROLL - 200, SCROLL - 200, SCROLL - 249, SCROLL - 249,
+		SCROLL - 100, SCROLL - 100, SCROLL, SCROLL, SCROLL, SCROLL + 100,
+		SCROLL + 100, SCROLL + 200, SCROLL + 300, SCROLL + 400, SCROLL + 500};
+
+static const uint16_t scrollTicks2[] = {
+		300, 300, 300, SCROLL, SCROLL, SCROLL,
+		SCROLL, SCROLL, SCROLL, SCROLL, SCROLL + 50, SCROLL + 50,
+		SCROLL + 100, SCROLL + 100, SCROLL + 200, SCROLL + 200, SCROLL + 200, SCROLL + 300,
+		SCROLL + 300, SCROLL + 400, SCROLL + 500, SCROLL + 600, SCROLL + 700};
+
+static const uint16_t scrollTicks3[] = {
+		500, 500, 500, SCROLL + 200, SCROLL + 200, SCROLL + 200,
+		SCROLL + 200, SCROLL + 200, SCROLL + 200, SCROLL + 200, SCROLL + 250, SCROLL + 250,
+		SCROLL + 300, SCROLL + 300, SCROLL + 400, SCROLL + 400, SCROLL + 400, SCROLL + 500,
+		SCROLL + 500, SCROLL + 600, SCROLL + 700, SCROLL + 800, SCROLL + 900};
+
+static const uint16_t scrollClicks[] = {
+		700, 700, 700, SCROLL + 400, SCROLL + 400, SCROLL + 400,
+		SCROLL + 400, SCROLL + 400, SCROLL + 400, SCROLL + 400, SCROLL + 450, SCROLL + 450,
+		SCROLL + 500, SCROLL + 500, SCROLL + 600, SCROLL + 600, SCROLL + 600, SCROLL + 700,
+		SCROLL + 700, SCROLL + 800, SCROLL + 900, SCROLL + 1000, SCROLL + 1100};
+
+/*
+ * BinaryModes_AdjustIntensity - step the intensity of a life test mode
+ * @param uint8_t* intensity - the intensity of the mode
+ * @param int8_t step - change of the intensity
+ * @return uint8_t - 1 if changed, 0 at the limit (1 or 255)
+ */
+static uint8_t BinaryModes_AdjustIntensity(uint8_t* intensity, int8_t step)
+{
+	int16_t value = (int16_t) *intensity + step;
+
+	if((value < 1) || (value > 255))
+		return 0;
+
+	*intensity = (uint8_t) value;
+	return 1;
+}
+
+/*
+ * BinaryModes_PlayAt - play a waveform at an intensity and wait for it.  The
+ * 		actuator intensity of its output mode is restored afterwards, so the
+ * 		other modes and effects play unscaled.
+ * @param const Waveform* waveform - the waveform
+ * @param uint8_t intensity - actuator intensity while it plays
+ */
+static void BinaryModes_PlayAt(const Waveform* waveform, uint8_t intensity)
+{
+	uint8_t outputMode = waveform->outputMode & HAPTICS_MODE_MASK;
+	uint8_t saved = Haptics_GetActuatorIntensity(outputMode);
+
+	Haptics_WaitDone();						// Nothing else plays at this intensity
+	Haptics_SetActuatorIntensity(outputMode, intensity);
+	Haptics_SendWaveform(waveform);
+	Haptics_WaitDone();						// The player rescales while it plays
+	Haptics_SetActuatorIntensity(outputMode, saved);
+}
+
+/*
+ * BinaryModes_Train - play a waveform with timed gaps.  Each gap starts when
+ * 		the effect has finished playing, like the sleep() chains the tables
+ * 		came from, so a gap shorter than the effect does not run them together.
+ * @param const Waveform* waveform - played first and after each interval
+ * @param const Waveform* last - played after the final interval instead
+ * @param const uint16_t* intervals - timer counts from the end of one effect to the next
+ * @param uint8_t count - number of intervals
+ */
+static void BinaryModes_Train(const Waveform* waveform, const Waveform* last, const uint16_t* intervals, uint8_t count)
+{
+	uint8_t i;
+
+	Haptics_SendWaveform(waveform);
+	for(i = 0; i < count; i++)
+	{
+		Haptics_WaitDone();
+		Timer_SleepUntil(Timer_Uptime() + intervals[i]);
+		Haptics_SendWaveform((i == count - 1) ? last : waveform);
+	}
+}
+
 /*
  * BinaryModes - function containing the extra binary mode button functions and effects
  */
@@ -99,59 +213,35 @@ void BinaryModes(void)
 		break;
 		case 0x30:		// Mode 6 - Life Test (2 seconds on, 1 second off) - LRA
 		{
-			static uint8_t amplitude = 0xD3;
-
-			unsigned char lra_testclick_data[] = {
-					amplitude, (0x05 * 0x08),
-					0x00, (0x07 * 0x08)
-			};
-			const Waveform lra_testclick = {LRA_AUTOON,4,lra_testclick_data};
+			static uint8_t intensity = HAPTICS_INTENSITY_FULL;	// drive scale of this mode's waveforms
 
 			switch(buttonPtr->referenceNumber)
 			{
 			case BUTTON1:	// Begin Life Test
 			{
-				unsigned char lra_onofflifetest_data[] = {
-						amplitude, 0xFF,
-						amplitude, 0x90,
-						0x80, 0xC8
-				};
-				const Waveform lra_onofflifetest = {LRA_AUTOON,6,lra_onofflifetest_data};
-
 				Haptics_HardwareMode(lra_onofflifetest.outputMode);	// Set hardware control pins
 				Haptics_StartPWM();									// Start PWM output
+				Haptics_SetActuatorIntensity(LRA_AUTOON, intensity);	// Not restored, runs until reset
 
 				while(1)
 				{
-					Haptics_OutputWaveform(lra_onofflifetest);
+					Haptics_OutputWaveform(&lra_onofflifetest);
 				}
 			}
 			case BUTTON2:	// Test buzz, used to determine output Vrms
 			{
-				unsigned char lra_on_data[] = {
-						amplitude, 0xFF,
-						0x80, 0x00
-				};
-				const Waveform lra_on = {LRA_AUTOON,2,lra_on_data};
-
-				Haptics_SendWaveform(lra_on);
+				BinaryModes_PlayAt(&lra_on, intensity);
 			}
 			case BUTTON3:	// Decrease output amplitude
 			{
-				if(amplitude > 1)
-				{
-					amplitude -= 1;
-					Haptics_SendWaveform(lra_testclick);
-				}
+				if(BinaryModes_AdjustIntensity(&intensity, -1))
+					BinaryModes_PlayAt(&lra_lifetestclick, intensity);
 				break;
 			}
 			case BUTTON4:	// Increase output amplitude
 			{
-				if(amplitude < 255)
-				{
-					amplitude += 1;
-					Haptics_SendWaveform(lra_testclick);
-				}
+				if(BinaryModes_AdjustIntensity(&intensity, 1))
+					BinaryModes_PlayAt(&lra_lifetestclick, intensity);
 				break;
 			}
 			default: __no_operation();
@@ -160,57 +250,35 @@ void BinaryModes(void)
 		break;
 		case 0x38:		// Mode 7 - Life Test, Infinite Buzz (LRA)
 		{
-			static uint8_t amplitude = 0xD3;
-
-			unsigned char lra_testclick_data[] = {
-					amplitude, 0x05,
-					0x00, 0x07
-			};
-			const Waveform lra_testclick = {LRA_AUTOON,4,lra_testclick_data};
+			static uint8_t intensity = HAPTICS_INTENSITY_FULL;	// drive scale of this mode's waveforms
 
 			switch(buttonPtr->referenceNumber)
 			{
 			case BUTTON1:	// Begin life test
 			{
-				unsigned char lra_infiniteonlifetest_data[] = {
-						amplitude, 0xFF
-				};
-				const Waveform lra_infiniteonlifetest = {LRA_AUTOON,2,lra_infiniteonlifetest_data};
-
-				Haptics_HardwareMode(lra_infiniteonlifetest.outputMode);	// Set hardware control pins
-				Haptics_StartPWM();											// Start PWM output
+				Haptics_HardwareMode(lra_on.outputMode);	// Set hardware control pins
+				Haptics_StartPWM();							// Start PWM output
+				Haptics_SetActuatorIntensity(LRA_AUTOON, intensity);	// Not restored, runs until reset
 
 				while(1)
 				{
-					Haptics_OutputWaveform(lra_infiniteonlifetest);
+					Haptics_OutputWaveform(&lra_on);
 				}
 			}
 			case BUTTON2:	// Test buzz
 			{
-				unsigned char lra_on_data[] = {
-						amplitude, 0xFF,
-						0x80, 0x00
-				};
-				const Waveform lra_on = {LRA_AUTOON,4,lra_on_data};
-
-				Haptics_SendWaveform(lra_on);
+				BinaryModes_PlayAt(&lra_on, intensity);
 			}
 			case BUTTON3:	// Decrease amplitude
 			{
-				if(amplitude > 1)
-				{
-					amplitude -= 1;
-					Haptics_SendWaveform(lra_testclick);
-				}
+				if(BinaryModes_AdjustIntensity(&intensity, -1))
+					BinaryModes_PlayAt(&lra_testclick, intensity);
 				break;
 			}
 			case BUTTON4:	// Increase amplitude
 			{
-				if(amplitude < 255)
-				{
-					amplitude += 1;
-					Haptics_SendWaveform(lra_testclick);
-				}
+				if(BinaryModes_AdjustIntensity(&intensity, 1))
+					BinaryModes_PlayAt(&lra_testclick, intensity);
 				break;
 			}
 			default: __no_operation();
@@ -219,49 +287,40 @@ void BinaryModes(void)
 		break;
 		case 0x48:		// Mode 9 - Frequency adjust auto-resonance off alert
 		{
-			const uint16_t frequencies[16] = {
-				18182,	// 220Hz
-				18605,	// 215Hz
-				19048, 	// 210Hz
-				19512, 	// 205Hz
-				20000,	// 200Hz
-				20513,  // 195Hz
-				21052,	// 190Hz
-				21621,	// 185Hz
-				22222, 	// 180Hz
-				22857,	// 175Hz
-				23529,	// 170Hz
-				24242,	// 165Hz
-				25000,	// 160Hz
-				15806,	// 155Hz
-				26667,	// 150Hz
-				27586	// 145Hz
+			static const uint16_t frequencies[16] = {
+				LRAFREQ_220, LRAFREQ_215, LRAFREQ_210, LRAFREQ_205,
+				LRAFREQ_200, LRAFREQ_195, LRAFREQ_190, LRAFREQ_185,
+				LRAFREQ_180, LRAFREQ_175, LRAFREQ_170, LRAFREQ_165,
+				LRAFREQ_160, LRAFREQ_155, LRAFREQ_150, LRAFREQ_145
 			};
 
 			static uint8_t frequenciesPtr = 7;
+			uint16_t savedTick = Haptics_dumbModeTick;	// DUMBTICK or the 'r' sweep result
 
 			switch(buttonPtr->referenceNumber)
 			{
 			case BUTTON1:	// Auto-resonance On Alert (for comparison)
 			{
-				Haptics_SendWaveform(lra_alert);
+				Haptics_SendWaveform(&lra_alert);
 				break;
 			}
 			case BUTTON2:	// Auto-resonance off alert with frequency selected from Buttons 3 and 4
 			{
 				Haptics_dumbModeTick = frequencies[frequenciesPtr];
-				Haptics_SendWaveform(lra_alert_dumb);
-				Haptics_dumbModeTick = (unsigned int) DUMBTICK;  // Reset dumb mode tick
+				Haptics_SendWaveform(&lra_alert_dumb);
+				Haptics_WaitDone();		// frequency is read when the waveform starts
+				Haptics_dumbModeTick = savedTick;  // Reset dumb mode tick
 				break;
 			}
 			case BUTTON3:	// Auto-resonance off alert, decrease frequency button (5Hz increments)
 			{
-				if(frequenciesPtr < 16)
+				if(frequenciesPtr < 15)
 				{
 					frequenciesPtr++;
 					Haptics_dumbModeTick = frequencies[frequenciesPtr];
-					Haptics_SendWaveform(lra_alert_dumb);
-					Haptics_dumbModeTick = (unsigned int) DUMBTICK;  // Reset dumb mode tick
+					Haptics_SendWaveform(&lra_alert_dumb);
+					Haptics_WaitDone();		// frequency is read when the waveform starts
+					Haptics_dumbModeTick = savedTick;  // Reset dumb mode tick
 				}
 				break;
 			}
@@ -271,8 +330,9 @@ void BinaryModes(void)
 				{
 					frequenciesPtr--;
 					Haptics_dumbModeTick = frequencies[frequenciesPtr];
-					Haptics_SendWaveform(lra_alert_dumb);
-					Haptics_dumbModeTick = (unsigned int) DUMBTICK;  // Reset dumb mode tick
+					Haptics_SendWaveform(&lra_alert_dumb);
+					Haptics_WaitDone();		// frequency is read when the waveform starts
+					Haptics_dumbModeTick = savedTick;  // Reset dumb mode tick
 				}
 				break;
 			}
@@ -282,57 +342,35 @@ void BinaryModes(void)
 		break;
 		case 0x50: 	// Mode 10 - Life Test, Infinite Buzz (ERM)
 		{
-			static uint8_t amplitude = 0xE0;
-
-			unsigned char erm_testclick_data[] = {
-					amplitude, 0x05,
-					0x00, 0x07
-			};
-			const Waveform erm_testclick = {ERM,4,erm_testclick_data};
+			static uint8_t intensity = HAPTICS_INTENSITY_FULL;	// drive scale of this mode's waveforms
 
 			switch(buttonPtr->referenceNumber)
 			{
 			case BUTTON1:	// Begin life test
 			{
-				unsigned char erm_infiniteonlifetest_data[] = {
-						amplitude, 0xFF
-				};
-				const Waveform erm_infiniteonlifetest = {ERM,2,erm_infiniteonlifetest_data};
-
-				Haptics_HardwareMode(erm_infiniteonlifetest.outputMode);	// Set hardware control pins
-				Haptics_StartPWM();											// Start PWM output
+				Haptics_HardwareMode(erm_on.outputMode);	// Set hardware control pins
+				Haptics_StartPWM();							// Start PWM output
+				Haptics_SetActuatorIntensity(ERM, intensity);	// Not restored, runs until reset
 
 				while(1)
 				{
-					Haptics_OutputWaveform(erm_infiniteonlifetest);
+					Haptics_OutputWaveform(&erm_on);
 				}
 			}
 			case BUTTON2:	// Test buzz
 			{
-				unsigned char erm_on_data[] = {
-						amplitude, 0xFF,
-						0x80, 0x00
-				};
-				const Waveform erm_on = {ERM,4,erm_on_data};
-
-				Haptics_SendWaveform(erm_on);
+				BinaryModes_PlayAt(&erm_on, intensity);
 			}
 			case BUTTON3:	// Decrease amplitude
 			{
-				if(amplitude > 1)
-				{
-					amplitude -= 1;
-					Haptics_SendWaveform(erm_testclick);
-				}
+				if(BinaryModes_AdjustIntensity(&intensity, -1))
+					BinaryModes_PlayAt(&erm_testclick, intensity);
 				break;
 			}
 			case BUTTON4:	// Increase amplitude
 			{
-				if(amplitude < 255)
-				{
-					amplitude += 1;
-					Haptics_SendWaveform(erm_testclick);
-				}
+				if(BinaryModes_AdjustIntensity(&intensity, 1))
+					BinaryModes_PlayAt(&erm_testclick, intensity);
 				break;
 			}
 			default: __no_operation();
@@ -346,206 +384,22 @@ void BinaryModes(void)
 			{
 			case BUTTON1 :
 			{
-				Haptics_SendWaveform(lra_tick);
-				sleep(100);
-				Haptics_SendWaveform(lra_tick);
-				sleep(100);
-				Haptics_SendWaveform(lra_tick);
-				sleep(100);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL - 200);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL - 200);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL - 200);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL - 200);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL - 200);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL - 200);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL - 200);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL - 249);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL - 249);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL - 100);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL - 100);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL + 100);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL + 100);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL + 200);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL + 300);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL + 400);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL + 500);
-				Haptics_SendWaveform(lra_tick);
+				BinaryModes_Train(&lra_tick, &lra_tick, scrollTicks1, sizeof(scrollTicks1) / sizeof(scrollTicks1[0]));
 				break;
 			}
 			case BUTTON2 :
 			{
-				Haptics_SendWaveform(lra_tick);
-				sleep(300);
-				Haptics_SendWaveform(lra_tick);
-				sleep(300);
-				Haptics_SendWaveform(lra_tick);
-				sleep(300);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL+50);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL+50);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL+100);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL+100);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL+200);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL+200);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL+200);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL+300);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL+300);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL+400);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL+500);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL+600);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL+700);
-				Haptics_SendWaveform(lra_tick);
+				BinaryModes_Train(&lra_tick, &lra_tick, scrollTicks2, sizeof(scrollTicks2) / sizeof(scrollTicks2[0]));
 				break;
 			}
 			case BUTTON3 :
 			{
-				Haptics_SendWaveform(lra_tick);
-				sleep(500);
-				Haptics_SendWaveform(lra_tick);
-				sleep(500);
-				Haptics_SendWaveform(lra_tick);
-				sleep(500);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL + 200);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL + 200);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL + 200);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL + 200);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL + 200);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL + 200);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL + 200);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL + 250);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL + 250);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL + 300);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL + 300);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL + 400);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL + 400);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL + 400);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL + 500);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL + 500);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL + 600);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL + 700);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL + 800);
-				Haptics_SendWaveform(lra_tick);
-				sleep(SCROLL + 900);
-				Haptics_SendWaveform(lra_tick);
+				BinaryModes_Train(&lra_tick, &lra_tick, scrollTicks3, sizeof(scrollTicks3) / sizeof(scrollTicks3[0]));
 				break;
 				}
 			case BUTTON4 :
 			{
-				Haptics_SendWaveform(erm_click);
-				sleep(700);
-				Haptics_SendWaveform(erm_click);
-				sleep(700);
-				Haptics_SendWaveform(erm_click);
-				sleep(700);
-				Haptics_SendWaveform(erm_click);
-				sleep(SCROLL + 400);
-				Haptics_SendWaveform(erm_click);
-				sleep(SCROLL + 400);
-				Haptics_SendWaveform(erm_click);
-				sleep(SCROLL + 400);
-				Haptics_SendWaveform(erm_click);
-				sleep(SCROLL + 400);
-				Haptics_SendWaveform(erm_click);
-				sleep(SCROLL + 400);
-				Haptics_SendWaveform(erm_click);
-				sleep(SCROLL + 400);
-				Haptics_SendWaveform(erm_click);
-				sleep(SCROLL + 400);
-				Haptics_SendWaveform(erm_click);
-				sleep(SCROLL + 450);
-				Haptics_SendWaveform(erm_click);
-				sleep(SCROLL + 450);
-				Haptics_SendWaveform(erm_click);
-				sleep(SCROLL + 500);
-				Haptics_SendWaveform(erm_click);
-				sleep(SCROLL + 500);
-				Haptics_SendWaveform(erm_click);
-				sleep(SCROLL + 600);
-				Haptics_SendWaveform(erm_click);
-				sleep(SCROLL + 600);
-				Haptics_SendWaveform(erm_click);
-				sleep(SCROLL + 600);
-				Haptics_SendWaveform(erm_click);
-				sleep(SCROLL + 700);
-				Haptics_SendWaveform(erm_click);
-				sleep(SCROLL + 700);
-				Haptics_SendWaveform(erm_click);
-				sleep(SCROLL + 800);
-				Haptics_SendWaveform(erm_click);
-				sleep(SCROLL + 900);
-				Haptics_SendWaveform(erm_click);
-				sleep(SCROLL + 1000);
-				Haptics_SendWaveform(erm_click);
-				sleep(SCROLL + 1100);
-				Haptics_SendWaveform(lra_tick);
+				BinaryModes_Train(&erm_click, &lra_tick, scrollClicks, sizeof(scrollClicks) / sizeof(scrollClicks[0]));
 				break;
 				}
 			}
@@ -560,7 +414,7 @@ void BinaryModes(void)
 					{
 						while(1)
 						{
-							Haptics_SendWaveform(lra_tick);
+							Haptics_SendWaveform(&lra_tick);
 							sleep(BPM);
 						}
 						break;
@@ -581,15 +435,15 @@ void BinaryModes(void)
 					}
 					case BUTTON4 :
 					{
-						Haptics_SendWaveform(lra_tick);
+						Haptics_SendWaveform(&lra_tick);
 														sleep(BPM);
-														Haptics_SendWaveform(lra_tick);
+														Haptics_SendWaveform(&lra_tick);
 														sleep(BPM);
-														Haptics_SendWaveform(lra_tick);
+														Haptics_SendWaveform(&lra_tick);
 														sleep(BPM);
-														Haptics_SendWaveform(lra_tick);
+														Haptics_SendWaveform(&lra_tick);
 														sleep(BPM);
-														Haptics_SendWaveform(lra_tick);
+														Haptics_SendWaveform(&lra_tick);
 						break;
 					}
 
@@ -71,6 +71,29 @@
  ******************************************************************************/
 
 #include "CTS_HAL.h"
+#include "../Timer.h"
+
+// TA0 is the time base of Timer.c.  A HAL that takes it has to hand back how
+// long it held TA0 (Timer_Borrow, Timer_Return), these cannot tell: the
+// fRO_*_TA0_SW gates run for a capacitance dependent time TA0 does not count,
+// and the WDTA can be gated by VLO or X_CLK whose rate is unknown here.
+#if defined(fRO_COMPAp_TA0_SW) || defined(fRO_PINOSC_TA0_SW) || defined(fRO_COMPB_TA0_SW)
+#error "Software gated TA0 HALs would stop the timer service, use a WDT gated or TA1 HAL"
+#endif
+#if defined(RO_COMPB_TA0_WDTA)
+#error "RO_COMPB_TA0_WDTA would stop the timer service, use RO_COMPB_TA1_WDTA"
+#endif
+
+// SMCLK cycles a scan holds TA0 beyond the gate or oscillator time the HALs
+// count, estimated from their instructions at 8MHz: the context save and
+// restore with Timer_Borrow and Timer_Return per scan, and per element the
+// port and gate setup and the captures.  A WDT gate adds the interrupt entry
+// and exit and the wake from LPM, the LPM3 DCO start at its data sheet
+// maximum.  See Timer.h for the error that is left.
+#define CTS_SCAN_CYCLES			300
+#define CTS_WDT_ELEMENT_CYCLES	140		// WDT gated, one gate interrupt per element
+#define CTS_SW_ELEMENT_CYCLES	60		// gated in software, polled
+#define CTS_RC_RUN_CYCLES		200		// RC_PAIR_TA0 port setup per charge and discharge
 
 #ifdef RO_COMPAp_TA0_WDTp
 /***************************************************************************//**
@@ -123,6 +146,9 @@ void TI_CTS_RO_COMPAp_TA0_WDTp_HAL(const struct Sensor *group, uint16_t *counts)
     uint8_t contextSaveCaoutDir,contextSaveCaoutSel;  
     uint8_t contextSavetxclkDir,contextSavetxclkSel;    
     uint8_t contextSaveRefDir,contextSaveRefOutSel;  
+    // SMCLK cycles of one gate, by WDTp_GATE_ setting, to move the timer service on
+    static const uint16_t gateCycles[4] = {32768, 8192, 512, 64};
+    uint32_t measureCycles;
     #ifdef SEL2REGISTER
     uint8_t contextSaveCaoutSel2,contextSaveTxclkSel2; 
     
@@ -134,6 +160,7 @@ void TI_CTS_RO_COMPAp_TA0_WDTp_HAL(const struct Sensor *group, uint16_t *counts)
     contextSaveWDTCTL = WDTCTL;
     contextSaveWDTCTL &= 0x00FF;
     contextSaveWDTCTL |= WDTPW;        
+    Timer_Borrow();                        // TA0 is the time base of Timer.c
     contextSaveTACTL = TACTL;
     contextSaveTACCTL1 = TACCTL1;
     contextSaveTACCR1 = TACCR1;
@@ -165,6 +192,12 @@ void TI_CTS_RO_COMPAp_TA0_WDTp_HAL(const struct Sensor *group, uint16_t *counts)
     CACTL1 |= CAON;                       // Turn on comparator
     CAPD |= (group->capdBits); 
     IE1 |= WDTIE;                         // enable WDT interrupt
+    measureCycles = (uint32_t) gateCycles[group->accumulationCycles & WDTp_GATE_64] * group->numElements;
+    if(group->measGateSource == GATE_WDTp_ACLK)
+    {
+        measureCycles *= Timer_smclkPerCount;
+    }
+    measureCycles += CTS_SCAN_CYCLES + (uint32_t) CTS_WDT_ELEMENT_CYCLES * group->numElements;
 	
     for (i = 0; i<(group->numElements); i++)
     {
@@ -215,6 +248,7 @@ void TI_CTS_RO_COMPAp_TA0_WDTp_HAL(const struct Sensor *group, uint16_t *counts)
     *(group->txclkSelRegister) = contextSavetxclkSel;    
     *(group->refPxdirRegister) = contextSaveRefDir;
     *(group->refPxoutRegister) = contextSaveRefOutSel;  
+    Timer_Return(measureCycles);
 }
 #endif
 
@@ -389,11 +423,13 @@ void TI_CTS_fRO_COMPAp_SW_TA0_HAL(const struct Sensor *group, uint16_t *counts)
     uint8_t contextSaveCACTL1,contextSaveCACTL2,contextSaveCAPD;
     uint8_t contextSaveCaoutDir,contextSaveCaoutSel;  
     uint8_t contextSaveRefDir,contextSaveRefOutSel;  
+    uint32_t measureCycles = 0;
     #ifdef SEL2REGISTER
     uint8_t contextSaveCaoutSel2,contextSaveTxclkSel2; 
     
     contextSaveCaoutSel2 = *(group->caoutSel2Register);
     #endif    
+    Timer_Borrow();                        // TA0 is the time base of Timer.c
     contextSaveTACTL = TACTL;
     contextSaveTACCTL0 = TACCTL0;
     contextSaveTACCTL1 = TACCTL1;
@@ -429,7 +465,7 @@ void TI_CTS_fRO_COMPAp_SW_TA0_HAL(const struct Sensor *group, uint16_t *counts)
         CACTL2= group->refCactl2Bits + (group->arrayPtr[i])->inputBits;
         //**  Setup Gate Timer **************
         // Set duration of sensor measurment
-        TACTL = group->measureGateSource+group->sourceScale+TACLR+MC_2;
+        TACTL = group->measGateSource+group->sourceScale+TACLR+MC_2;
         TACCTL0 ^= CCIS0;                     // Create SW capture of CCR0
         for(j = group->accumulationCycles; j > 0; j--)
         {
@@ -441,7 +477,13 @@ void TI_CTS_fRO_COMPAp_SW_TA0_HAL(const struct Sensor *group, uint16_t *counts)
         counts[i] -= TACCR0;               // Save result
         TACCTL0 &= ~CCIFG;
         TACCTL1 &= ~CCIFG;
+        measureCycles += (uint32_t) counts[i] << ((group->sourceScale & ID_3) >> 6);
+    }
+    if(group->measGateSource == TIMER_ACLK)
+    {
+        measureCycles *= Timer_smclkPerCount;
     }
+    measureCycles += CTS_SCAN_CYCLES + (uint32_t) CTS_SW_ELEMENT_CYCLES * group->numElements;
     // End Sequence
     //** Context Restore
     //  WDTp: IE1, WDCTL
@@ -463,6 +505,7 @@ void TI_CTS_fRO_COMPAp_SW_TA0_HAL(const struct Sensor *group, uint16_t *counts)
     *(group->caoutSelRegister) = contextSaveCaoutSel;  
     *(group->refPxdirRegister) = contextSaveRefDir;
     *(group->refPxoutRegister) = contextSaveRefOutSel;  
+    Timer_Return(measureCycles);
 }
 #endif
 
@@ -781,6 +824,7 @@ void TI_CTS_RC_PAIR_TA0_HAL(const struct Sensor *group,uint16_t *counts)
 
     uint8_t contextSaveinputPxout,contextSaveinputPxdir,contextSavereferencePxout;
     uint8_t contextSavereferencePxdir;
+    uint32_t measureCycles = CTS_SCAN_CYCLES;
 
     #ifdef __MSP430_HAS_SFR__
     uint16_t contextSaveTA0CTL,contextSaveTA0CCR0;
@@ -793,6 +837,7 @@ void TI_CTS_RC_PAIR_TA0_HAL(const struct Sensor *group,uint16_t *counts)
     contextSaveTACTL = TACTL; 
     contextSaveTACCR0 = TACCR0; 
     #endif
+    Timer_Borrow();                        // TA0 is the time base of Timer.c
 
 //** Setup Measurement timer****************************************************
 // Choices are TA0,TA1,TB0,TB1,TD0,TD1 these choices are pushed up into the 
@@ -884,6 +929,8 @@ void TI_CTS_RC_PAIR_TA0_HAL(const struct Sensor *group,uint16_t *counts)
         #else
         counts[i] = TAR;    
         #endif
+        measureCycles += counts[i];            // SMCLK, the timer is stopped for the port setup
+        measureCycles += CTS_SW_ELEMENT_CYCLES + (uint32_t) CTS_RC_RUN_CYCLES * group->accumulationCycles;
         // Context Restore
         *((group->arrayPtr[i])->inputPxoutRegister) = contextSaveinputPxout;
         *((group->arrayPtr[i])->inputPxdirRegister) = contextSaveinputPxdir;     
@@ -899,7 +946,7 @@ void TI_CTS_RC_PAIR_TA0_HAL(const struct Sensor *group,uint16_t *counts)
     TACTL = contextSaveTACTL;
     TACCR0 = contextSaveTACCR0;
     #endif
-
+    Timer_Return(measureCycles);
 }
 #endif
 
@@ -996,12 +1043,16 @@ void TI_CTS_RO_PINOSC_TA0_WDTp_HAL(const struct Sensor *group,uint16_t *counts)
     uint16_t contextSaveWDTCTL;
     uint16_t contextSaveTA0CTL,contextSaveTA0CCTL1,contextSaveTA0CCR1;
     uint8_t contextSaveSel,contextSaveSel2;
+    // SMCLK cycles of one gate, by WDTp_GATE_ setting, to move the timer service on
+    static const uint16_t gateCycles[4] = {32768, 8192, 512, 64};
+    uint32_t measureCycles;
 
     contextSaveSR = __get_SR_register();
     contextSaveIE1 = IE1;
     contextSaveWDTCTL = WDTCTL;
     contextSaveWDTCTL &= 0x00FF;
     contextSaveWDTCTL |= WDTPW;        
+    Timer_Borrow();                        // TA0 is the time base of Timer.c
     contextSaveTA0CTL = TA0CTL;
     contextSaveTA0CCTL1 = TA0CCTL1;
     contextSaveTA0CCR1 = TA0CCR1;
@@ -1014,6 +1065,12 @@ void TI_CTS_RO_PINOSC_TA0_WDTp_HAL(const struct Sensor *group,uint16_t *counts)
     TA0CTL = TASSEL_3+MC_2;                // TACLK, cont mode
     TA0CCTL1 = CM_3+CCIS_2+CAP;            // Pos&Neg,GND,Cap
     IE1 |= WDTIE;                         // enable WDT interrupt
+    measureCycles = (uint32_t) gateCycles[group->accumulationCycles & WDTp_GATE_64] * group->numElements;
+    if(group->measGateSource == GATE_WDT_ACLK)
+    {
+        measureCycles *= Timer_smclkPerCount;
+    }
+    measureCycles += CTS_SCAN_CYCLES + (uint32_t) CTS_WDT_ELEMENT_CYCLES * group->numElements;
     for (i = 0; i<(group->numElements); i++)
     {
         // Context Save
@@ -1054,6 +1111,7 @@ void TI_CTS_RO_PINOSC_TA0_WDTp_HAL(const struct Sensor *group,uint16_t *counts)
     TA0CTL = contextSaveTA0CTL;
     TA0CCTL1 = contextSaveTA0CCTL1;
     TA0CCR1 = contextSaveTA0CCR1;
+    Timer_Return(measureCycles);
 }
 #endif
 
@@ -1083,10 +1141,17 @@ void TI_CTS_RO_PINOSC_TA0_HAL(const struct Sensor *group,uint16_t *counts)
 //  Ports: PxSEL, PxSEL2 
     uint16_t contextSaveTA0CTL,contextSaveTA0CCTL0,contextSaveTA0CCR0;
     uint8_t contextSaveSel,contextSaveSel2;
+    uint32_t measureCycles;
 
+    Timer_Borrow();                        // TA0 is the time base of Timer.c
     contextSaveTA0CTL = TA0CTL;
     contextSaveTA0CCTL0 = TA0CCTL0;
     contextSaveTA0CCR0 = TA0CCR0;
+    // Each element waits for one ACLK edge, then accumulationCycles more,
+    // two edges per ACLK count
+    measureCycles = ((uint32_t) group->accumulationCycles + 1) * group->numElements;
+    measureCycles = measureCycles * Timer_smclkPerCount / 2;
+    measureCycles += CTS_SCAN_CYCLES + (uint32_t) CTS_SW_ELEMENT_CYCLES * group->numElements;
 
 	//** Setup Measurement timer***************************************************
 	// Choices are TA0,TA1,TB0,TB1,TD0,TD1 these choices are pushed up into the 
@@ -1122,6 +1187,7 @@ void TI_CTS_RO_PINOSC_TA0_HAL(const struct Sensor *group,uint16_t *counts)
     TA0CTL = contextSaveTA0CTL;
     TA0CCTL0 = contextSaveTA0CCTL0;
     TA0CCR0 = contextSaveTA0CCR0;
+    Timer_Return(measureCycles);
 }
 #endif
 
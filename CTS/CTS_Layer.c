@@ -64,6 +64,7 @@
  ******************************************************************************/
 
 #include "CTS_Layer.h"
+#include "../Flash.h"
 #include <stdlib.h>
 
 // Global variables for sensing
@@ -73,6 +74,8 @@ uint16_t baseCnt[TOTAL_NUMBER_OF_ELEMENTS];
 uint16_t measCnt[MAXIMUM_NUMBER_OF_ELEMENTS_PER_SENSOR];
 #endif
 uint16_t ctsStatusReg = (DOI_INC+TRADOI_FAST+TRIDOI_SLOW);
+// Calibration table in INFO flash, 0 when the structure.c values are used
+const struct CalibrationTable *ctsCalibration = 0;
 #endif
 
 /***************************************************************************//**
@@ -241,6 +244,58 @@ void TI_CAPT_Reset_Tracking(void)
     ctsStatusReg = (DOI_INC+TRADOI_FAST+TRIDOI_SLOW);
 }
 
+/***************************************************************************//**
+ * @brief   Use the calibration table stored in INFO flash, if it is valid
+ * 
+ *          The threshold and maxResponse values of each element are taken
+ *          from the calibration table instead of structure.c when the table
+ *          signature and checksum are correct.  Table entries of 0 keep the
+ *          structure.c value for that element.
+ * @param   none
+ * @return  result Indication if the calibration table is (1) or is not (0)
+ *          being used
+ ******************************************************************************/
+uint8_t TI_CAPT_Load_Calibration(void)
+{
+    const struct CalibrationTable *table = CALIBRATION_TABLE;
+
+    ctsCalibration = 0;
+    if((table->signature == CALIBRATION_SIGNATURE)
+       &&
+       (table->checksum == Calibration_Checksum(table)))
+    {
+        ctsCalibration = table;
+    }
+    return (ctsCalibration != 0);
+}
+
+/***************************************************************************//**
+ * @brief   Store a new calibration table in INFO flash and start using it
+ * @param   threshold Array of TOTAL_NUMBER_OF_ELEMENTS thresholds, indexed by
+ *          baseOffset + element
+ * @param   maxResponse Array of TOTAL_NUMBER_OF_ELEMENTS maximum responses
+ * @return  result Indication if the calibration table is (1) or is not (0)
+ *          being used
+ ******************************************************************************/
+uint8_t TI_CAPT_Save_Calibration(const uint16_t *threshold, const uint16_t *maxResponse)
+{
+    uint8_t i;
+    struct CalibrationTable table;
+
+    table.signature = CALIBRATION_SIGNATURE;
+    for(i = 0; i < TOTAL_NUMBER_OF_ELEMENTS; i++)
+    {
+        table.threshold[i] = threshold[i];
+        table.maxResponse[i] = maxResponse[i];
+    }
+    table.checksum = Calibration_Checksum(&table);
+
+    ctsCalibration = 0;
+    Flash_EraseSegment((uint8_t *)CALIBRATION_TABLE);
+    Flash_Write((uint8_t *)CALIBRATION_TABLE, (const uint8_t *)&table, sizeof(table));
+    return TI_CAPT_Load_Calibration();
+}
+
 /***************************************************************************//**
  * @brief   Update the Baseline Tracking algorithm Direction of Interest
  * @param   direction Direction of increasing or decreasing capacitance
@@ -287,15 +342,32 @@ void TI_CAPT_Custom(const struct Sensor* groupOfElements, uint16_t * deltaCnt)
 { 
     uint8_t j;
     uint16_t tempCnt;
+    uint16_t threshold;
     ctsStatusReg &= ~ EVNT;
         
     // This section calculates the delta counts*************************************
     //******************************************************************************
     TI_CAPT_Raw(groupOfElements, &deltaCnt[0]); // measure group of sensors
+
+#ifdef GUARD_CHANNEL
+    // Remove the common-mode shift seen by the guard element, or skip the 
+    // sensor entirely while the shift is large enough to mask a touch.
+    if(groupOfElements->guardSensor 
+       && Guard_Compensate(groupOfElements, &deltaCnt[0]))
+    {
+        for (j = 0; j < (groupOfElements->numElements); j++)
+        {
+            deltaCnt[j] = 0;
+        }
+        ctsStatusReg &= ~PAST_EVNT;
+        return;
+    }
+#endif
   
     for (j = 0; j < (groupOfElements->numElements); j++)
     {  
         tempCnt = deltaCnt[j];
+        threshold = Element_Threshold(groupOfElements, j);
         if(deltaCnt[j])
         {
         if(((ctsStatusReg & DOI_MASK) && (groupOfElements->halDefinition & RO_MASK))
@@ -309,11 +381,11 @@ void TI_CAPT_Custom(const struct Sensor* groupOfElements, uint16_t * deltaCnt)
                 // , set delta to zero
                 deltaCnt[j] = 0;
                 // Limit the change in the opposite direction to the threshold
-                if(((groupOfElements->arrayPtr[j])->threshold)
+                if((threshold)
                 &&
-                (baseCnt[j+groupOfElements->baseOffset]+(groupOfElements->arrayPtr[j])->threshold < tempCnt))
+                (baseCnt[j+groupOfElements->baseOffset]+threshold < tempCnt))
                 {
-                    tempCnt = baseCnt[j+groupOfElements->baseOffset]+(groupOfElements->arrayPtr[j])->threshold;
+                    tempCnt = baseCnt[j+groupOfElements->baseOffset]+threshold;
                 }
             }
             else
@@ -333,11 +405,11 @@ void TI_CAPT_Custom(const struct Sensor* groupOfElements, uint16_t * deltaCnt)
                 // If capacitance increases, set delta to zero
                 deltaCnt[j] = 0;
                 // Limit the change in the opposite direction to the threshold
-                if(((groupOfElements->arrayPtr[j])->threshold)
+                if((threshold)
                 &&
-                (baseCnt[j+groupOfElements->baseOffset] > tempCnt+(groupOfElements->arrayPtr[j])->threshold))
+                (baseCnt[j+groupOfElements->baseOffset] > tempCnt+threshold))
                 {
-                    tempCnt = baseCnt[j+groupOfElements->baseOffset]-(groupOfElements->arrayPtr[j])->threshold;
+                    tempCnt = baseCnt[j+groupOfElements->baseOffset]-threshold;
                 }
             }
             else       
@@ -378,7 +450,7 @@ void TI_CAPT_Custom(const struct Sensor* groupOfElements, uint16_t * deltaCnt)
         }
             // delta counts are either 0, less than threshold, or greater than threshold
             // never negative
-        else if(deltaCnt[j]<(groupOfElements->arrayPtr[j])->threshold && !(ctsStatusReg & PAST_EVNT))
+        else if(deltaCnt[j]<threshold && !(ctsStatusReg & PAST_EVNT))
         {    //if delta counts is positive but less than threshold,
           switch ((ctsStatusReg & TRIDOI_FAST))
           {
@@ -421,7 +493,7 @@ void TI_CAPT_Custom(const struct Sensor* groupOfElements, uint16_t * deltaCnt)
           baseCnt[j+groupOfElements->baseOffset] = (tempCnt)+(baseCnt[j+groupOfElements->baseOffset]);
         }
         //if delta counts above the threshold, event has occurred
-        else if(deltaCnt[j]>=(groupOfElements->arrayPtr[j])->threshold)
+        else if(deltaCnt[j]>=threshold)
         {
           ctsStatusReg |= EVNT;
           ctsStatusReg |= PAST_EVNT;
@@ -722,18 +794,21 @@ uint8_t Dominant_Element(const struct Sensor* groupOfElements, uint16_t* deltaCn
     uint8_t i;
     uint16_t percentDelta=0; 
     uint8_t dominantElement=0;
+    uint16_t threshold, maxResponse;
     for(i=0;i<groupOfElements->numElements;i++)
     {  
-        if(deltaCnt[i]>=(groupOfElements->arrayPtr[i])->threshold)
+        threshold = Element_Threshold(groupOfElements, i);
+        maxResponse = Element_MaxResponse(groupOfElements, i);
+        if(deltaCnt[i]>=threshold)
         {
-            if(deltaCnt[i] > ((groupOfElements->arrayPtr[i])->maxResponse))
+            if(deltaCnt[i] > maxResponse)
             {
-                deltaCnt[i] = (groupOfElements->arrayPtr[i])->maxResponse;
+                deltaCnt[i] = maxResponse;
                 // limit response to the maximum
             }
             // (maxResponse - threshold) cannot exceed 655
             // 100*(delta - threshold) / (maxResponse - threshold)
-            deltaCnt[i] = (100*(deltaCnt[i]-(groupOfElements->arrayPtr[i])->threshold))/((groupOfElements->arrayPtr[i])->maxResponse - (groupOfElements->arrayPtr[i])->threshold);
+            deltaCnt[i] = (100*(deltaCnt[i]-threshold))/(maxResponse - threshold);
             if(deltaCnt[i] >= percentDelta)
             {
                 //update percentDelta
@@ -748,4 +823,143 @@ uint8_t Dominant_Element(const struct Sensor* groupOfElements, uint16_t* deltaCn
     } // end for loop    
     return dominantElement;
 }
+
+/***************************************************************************//**
+ * @ingroup CTS_support
+ * @brief   Threshold of an element, from the calibration table if loaded
+ * @param   groupOfElements Pointer to Sensor containing the element
+ * @param   index Index of the element within the Sensor
+ * @return  result Threshold in counts
+ ******************************************************************************/
+uint16_t Element_Threshold(const struct Sensor* groupOfElements, uint8_t index)
+{
+    if(ctsCalibration && ctsCalibration->threshold[groupOfElements->baseOffset+index])
+    {
+        return ctsCalibration->threshold[groupOfElements->baseOffset+index];
+    }
+    return (groupOfElements->arrayPtr[index])->threshold;
+}
+
+/***************************************************************************//**
+ * @ingroup CTS_support
+ * @brief   Maximum response of an element, from the calibration table if loaded
+ * @param   groupOfElements Pointer to Sensor containing the element
+ * @param   index Index of the element within the Sensor
+ * @return  result Maximum response in counts
+ ******************************************************************************/
+uint16_t Element_MaxResponse(const struct Sensor* groupOfElements, uint8_t index)
+{
+    if(ctsCalibration && ctsCalibration->maxResponse[groupOfElements->baseOffset+index])
+    {
+        return ctsCalibration->maxResponse[groupOfElements->baseOffset+index];
+    }
+    return (groupOfElements->arrayPtr[index])->maxResponse;
+}
+
+/***************************************************************************//**
+ * @ingroup CTS_support
+ * @brief   Checksum of a calibration table
+ * @param   table Pointer to calibration table
+ * @return  result Two's complement of the sum of all words before checksum
+ ******************************************************************************/
+uint16_t Calibration_Checksum(const struct CalibrationTable *table)
+{
+    uint8_t i;
+    uint16_t sum = table->signature;
+
+    for(i = 0; i < TOTAL_NUMBER_OF_ELEMENTS; i++)
+    {
+        sum += table->threshold[i] + table->maxResponse[i];
+    }
+    return (uint16_t)(~sum + 1);
+}
+
+#ifdef GUARD_CHANNEL
+/***************************************************************************//**
+ * @ingroup CTS_support
+ * @brief   Remove the common-mode shift measured by a guard element
+ * 
+ *          This function measures the guard Sensor of groupOfElements and
+ *          computes the guard delta in the direction of interest.  With 
+ *          GUARD_SUBTRACT the raw counts are shifted back by the guard delta so
+ *          that the normal baseline tracking only sees the differential 
+ *          change.  With GUARD_GATE a guard delta at or above the guard
+ *          element threshold is reported so the caller can ignore the 
+ *          measurement without disturbing the baseline.
+ *          The guard baseline tracks quickly against the direction of interest
+ *          and one count per measurement for small shifts within the direction
+ *          of interest; it is held while a larger common-mode shift is present.
+ * @param   groupOfElements Pointer to guarded Sensor
+ * @param   counts Raw measurements of groupOfElements, adjusted in place
+ * @return  result Indication if the sensor is (1) or is not (0) gated
+ ******************************************************************************/
+uint8_t Guard_Compensate(const struct Sensor* groupOfElements, uint16_t* counts)
+{
+    uint8_t j;
+    uint8_t decreasing;
+    uint16_t guardCnt, shift;
+    const struct Sensor *guardGroup = groupOfElements->guardSensor;
+    uint16_t *guardBase = &baseCnt[guardGroup->baseOffset];
+    uint16_t guardThreshold = Element_Threshold(guardGroup, 0);
+
+    TI_CAPT_Raw(guardGroup, &guardCnt);     // guard sensor has one element
+
+    // RO method with increasing capacitance (or RC method with decreasing
+    // capacitance) shows up as decreasing counts
+    decreasing = (((ctsStatusReg & DOI_MASK) && (guardGroup->halDefinition & RO_MASK))
+                 ||
+                 ((!(ctsStatusReg & DOI_MASK)) && (!(guardGroup->halDefinition & RO_MASK))));
+    shift = 0;
+    if(decreasing && (*guardBase > guardCnt))
+    {
+        shift = *guardBase - guardCnt;
+    }
+    else if(!decreasing && (guardCnt > *guardBase))
+    {
+        shift = guardCnt - *guardBase;
+    }
+
+    // Guard baseline tracking
+    if(shift == 0)
+    {
+        *guardBase = (*guardBase/2) + (guardCnt/2);
+    }
+    else if(shift < guardThreshold/2)
+    {
+        if(guardCnt < *guardBase)
+        {
+            *guardBase = *guardBase - 1;
+        }
+        else
+        {
+            *guardBase = *guardBase + 1;
+        }
+    }
+
+    if((groupOfElements->guardMode & GUARD_GATE) && guardThreshold 
+       && (shift >= guardThreshold))
+    {
+        return 1;
+    }
+    if((groupOfElements->guardMode & GUARD_SUBTRACT) && shift)
+    {
+        for (j = 0; j < (groupOfElements->numElements); j++)
+        {
+            if(counts[j] == 0)
+            {
+                continue;                   // no measurement, leave as is
+            }
+            if(decreasing)
+            {
+                counts[j] = (counts[j] > 0xFFFF - shift) ? 0xFFFF : counts[j] + shift;
+            }
+            else
+            {
+                counts[j] = (counts[j] > shift) ? counts[j] - shift : 1;
+            }
+        }
+    }
+    return 0;
+}
+#endif
 #endif
@@ -53,6 +53,8 @@
  *              - TI_CAPT_Reset_Tracking()
  *              - TI_CAPT_Update_Tracking_DOI()
  *              - TI_CAPT_Update_Tracking_Rate()
+ *              - TI_CAPT_Load_Calibration()
+ *              - TI_CAPT_Save_Calibration()
  *              - TI_CAPT_Update_Baseline()
  *              - TI_CAPT_Raw()
  *              - TI_CAPT_Custom()
@@ -106,6 +108,26 @@
 
 //! @}
 
+#ifdef TOTAL_NUMBER_OF_ELEMENTS
+//! \name Calibration Table
+//! @{
+//
+//! Threshold and maxResponse values measured on the board, kept in the INFOD
+//! flash segment (64 bytes at 0x1000) and indexed by baseOffset + element.
+//! An entry of 0 keeps the structure.c value.
+#define CALIBRATION_SIGNATURE   0xCA1B
+#define CALIBRATION_TABLE       ((const struct CalibrationTable *)0x1000)
+
+struct CalibrationTable{
+  uint16_t signature;                           // CALIBRATION_SIGNATURE
+  uint16_t threshold[TOTAL_NUMBER_OF_ELEMENTS];
+  uint16_t maxResponse[TOTAL_NUMBER_OF_ELEMENTS];
+  uint16_t checksum;                            // see Calibration_Checksum
+};
+
+//! @}
+#endif
+
 
 // API Calls
 void TI_CAPT_Init_Baseline(const struct Sensor*);
@@ -115,6 +137,11 @@ void TI_CAPT_Reset_Tracking(void);
 void TI_CAPT_Update_Tracking_DOI(uint8_t);
 void TI_CAPT_Update_Tracking_Rate(uint8_t);
 
+#ifdef TOTAL_NUMBER_OF_ELEMENTS
+uint8_t TI_CAPT_Load_Calibration(void);
+uint8_t TI_CAPT_Save_Calibration(const uint16_t*, const uint16_t*);
+#endif
+
 void TI_CAPT_Raw(const struct Sensor*, uint16_t*);
 
 void TI_CAPT_Custom(const struct Sensor *, uint16_t*);
@@ -126,5 +153,13 @@ uint16_t TI_CAPT_Wheel(const struct Sensor*);
 
 // Internal Calls
 uint8_t Dominant_Element (const struct Sensor*, uint16_t*);
+#ifdef TOTAL_NUMBER_OF_ELEMENTS
+uint16_t Element_Threshold (const struct Sensor*, uint8_t);
+uint16_t Element_MaxResponse (const struct Sensor*, uint8_t);
+uint16_t Calibration_Checksum (const struct CalibrationTable*);
+#endif
+#ifdef GUARD_CHANNEL
+uint8_t Guard_Compensate (const struct Sensor*, uint16_t*);
+#endif
 
 #endif
@@ -1,81 +1,117 @@
 //******************************************************************************
-//  RO_PINOSC_TA_WDTp example with the MSP430G2452
+//  structure.c
+//  DRV2603EVM-CT RevD, MSP430G2553
 //  threshold and maxResponse values must be updated for electrode design,
 //  system clock settings, selection of gate measurement source, and 
-//  accumulation cycles
+//  accumulation cycles.  CapTouch_Calibrate() can override them at run time.
 //******************************************************************************
+// Generated by tools/structure_gen.py from tools/board_drv2603evm.json.
+// Edit the board description and regenerate instead of editing by hand.
 
 #include "structure.h"
 #include "../CapTouchBoard.h"
 
-//PinOsc Volume down P2.0
+//PinOsc B1 P2.0
 const struct Element button1 = {
-	
-			  .inputPxselRegister = (unsigned char *)&P2SEL,
-              .inputPxsel2Register = (unsigned char *)&P2SEL2,  
+
+              .inputPxselRegister = (unsigned char *)&P2SEL,
+              .inputPxsel2Register = (unsigned char *)&P2SEL2,
               .inputBits = BIT0,
-              // measured for a 1Mhz SMCLK
-              .maxResponse = 0+655, // actual measure was 980
+              .maxResponse = 655,
               .threshold = 130,
               .referenceNumber = BUTTON1,
               .sequenceNumber = 0
-};      
+};
 
+//PinOsc B2 P2.1
 const struct Element button2 = {
 
-              .inputPxselRegister = (unsigned char *)&P2SEL,  
-              .inputPxsel2Register = (unsigned char *)&P2SEL2,  
+              .inputPxselRegister = (unsigned char *)&P2SEL,
+              .inputPxsel2Register = (unsigned char *)&P2SEL2,
               .inputBits = BIT1,
-              // measured for a 1Mhz SMCLK
-              .maxResponse = 150+655, // actual measure was 980
+              .maxResponse = 805,
               .threshold = 150,
               .referenceNumber = BUTTON2,
               .sequenceNumber = 1
-};  
+};
+
+//PinOsc B3 P2.2
 const struct Element button3 = {
 
-              .inputPxselRegister = (unsigned char *)&P2SEL,  
-              .inputPxsel2Register = (unsigned char *)&P2SEL2,  
+              .inputPxselRegister = (unsigned char *)&P2SEL,
+              .inputPxsel2Register = (unsigned char *)&P2SEL2,
               .inputBits = BIT2,
-              // measured for a 1Mhz SMCLK
-              .maxResponse = 130+655, // actual measure was 980
+              .maxResponse = 785,
               .threshold = 130,
               .referenceNumber = BUTTON3,
               .sequenceNumber = 2
-}; 
+};
+
+//PinOsc B4 P2.3
 const struct Element button4 = {
 
-              .inputPxselRegister = (unsigned char *)&P2SEL,  
-              .inputPxsel2Register = (unsigned char *)&P2SEL2,  
+              .inputPxselRegister = (unsigned char *)&P2SEL,
+              .inputPxsel2Register = (unsigned char *)&P2SEL2,
               .inputBits = BIT3,
-              // measured for a 1Mhz SMCLK
-              .maxResponse = 120+655, // actual measure was 980
+              .maxResponse = 775,
               .threshold = 120,
               .referenceNumber = BUTTON4,
               .sequenceNumber = 3
-};           
+};
+
+//PinOsc "-" P2.4
 const struct Element mode_down = {
 
-              .inputPxselRegister = (unsigned char *)&P2SEL,  
-              .inputPxsel2Register = (unsigned char *)&P2SEL2,  
+              .inputPxselRegister = (unsigned char *)&P2SEL,
+              .inputPxsel2Register = (unsigned char *)&P2SEL2,
               .inputBits = BIT4,
-              // measured for a 1Mhz SMCLK
-              .maxResponse = 130+655, // actual measure was 980
+              .maxResponse = 785,
               .threshold = 130,
               .referenceNumber = BUTTONMINUS,
               .sequenceNumber = 4
-};      
+};
+
+//PinOsc "+" P2.5
 const struct Element mode_up = {
 
-              .inputPxselRegister = (unsigned char *)&P2SEL,  
-              .inputPxsel2Register = (unsigned char *)&P2SEL2,  
+              .inputPxselRegister = (unsigned char *)&P2SEL,
+              .inputPxsel2Register = (unsigned char *)&P2SEL2,
               .inputBits = BIT5,
-              // measured for a 1Mhz SMCLK
-              .maxResponse = 150+655, // actual measure was 980
+              .maxResponse = 805,
               .threshold = 150,
               .referenceNumber = BUTTONPLUS,
               .sequenceNumber = 5
-};              
+};
+
+#ifdef GUARD_CHANNEL
+// The guard electrode surrounds the buttons and is not touched in normal use.
+// Its threshold is the common-mode shift at which the guarded sensors are
+// gated (see GUARD_GATE).
+//PinOsc Guard P2.7
+const struct Element guard_element = {
+
+              .inputPxselRegister = (unsigned char *)&P2SEL,
+              .inputPxsel2Register = (unsigned char *)&P2SEL2,
+              .inputBits = BIT7,
+              .maxResponse = 0,
+              .threshold = 100,
+              .referenceNumber = 0,
+              .sequenceNumber = 6
+};
+
+const struct Sensor guard =
+               { 
+                  .halDefinition = RO_PINOSC_TA0_WDTp,
+                  .numElements = 1,
+                  .baseOffset = 6,
+                  // Pointer to elements
+                  .arrayPtr[0] = &guard_element,
+                  // Timer Information
+                  .measGateSource= GATE_WDT_SMCLK,
+                  .accumulationCycles= WDTp_GATE_512,
+                  .guardSensor = 0
+               };
+#endif
 
 //*** Sensor   *******************************************************/
 // This defines the grouping of sensors, the method to measure change in
@@ -87,16 +123,17 @@ const struct Sensor buttons =
                   .numElements = 4,
                   .baseOffset = 0,
                   // Pointer to elements
-                  .arrayPtr[0] = &button1,  // point to first element
-                  .arrayPtr[1] = &button2,  // 
-                  .arrayPtr[2] = &button3,  // 
-                  .arrayPtr[3] = &button4,  //
+                  .arrayPtr[0] = &button1,
+                  .arrayPtr[1] = &button2,
+                  .arrayPtr[2] = &button3,
+                  .arrayPtr[3] = &button4,
                   // Timer Information
-                  .measGateSource= GATE_WDT_SMCLK,     //  0->SMCLK, 1-> ACLK
-                  //.accumulationCycles= WDTp_GATE_32768             //32768
-                  //.accumulationCycles= WDTp_GATE_8192               // 8192
-                  .accumulationCycles= WDTp_GATE_512             //512
-                  //.accumulationCycles= WDTp_GATE_64             //64                  
+                  .measGateSource= GATE_WDT_SMCLK,
+                  .accumulationCycles= WDTp_GATE_512,
+#ifdef GUARD_CHANNEL
+                  .guardSensor = &guard,
+                  .guardMode = GUARD_SUBTRACT + GUARD_GATE
+#endif
                };
 
 const struct Sensor mode_change =
@@ -105,12 +142,14 @@ const struct Sensor mode_change =
                   .numElements = 2,
                   .baseOffset = 4,
                   // Pointer to elements
-                  .arrayPtr[0] = &mode_down,  // point to first element
-                  .arrayPtr[1] = &mode_up,  // point to first element
+                  .arrayPtr[0] = &mode_down,
+                  .arrayPtr[1] = &mode_up,
                   // Timer Information
-                  .measGateSource= GATE_WDT_SMCLK,     //  0->SMCLK, 1-> ACLK
-                  //.accumulationCycles= WDTp_GATE_32768             //32768
-                  //.accumulationCycles= WDTp_GATE_8192               // 8192
-                  .accumulationCycles= WDTp_GATE_512             //512
-                  //.accumulationCycles= WDTp_GATE_64             //64                  
+                  .measGateSource= GATE_WDT_SMCLK,
+                  .accumulationCycles= WDTp_GATE_512,
+#ifdef GUARD_CHANNEL
+                  .guardSensor = &guard,
+                  .guardMode = GUARD_SUBTRACT + GUARD_GATE
+#endif
                };
+
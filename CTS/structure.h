@@ -25,9 +25,11 @@
 //******************************************************************************
 
 #include "msp430.h"
-//#include "msp430g2452.h"
 #include <stdint.h>
 
+// Generated by tools/structure_gen.py from tools/board_drv2603evm.json.
+// Edit the board description and regenerate instead of editing by hand.
+
 /* Public Globals */
 extern const struct Element button1;     // structure containing elements for B1
 extern const struct Element button2;     // structure containing elements for B2
@@ -36,16 +38,33 @@ extern const struct Element button4;     // structure containing elements for B4
 extern const struct Element mode_down;   // structure containing elements for "-"
 extern const struct Element mode_up;     // structure containing elements for "+"
 
-extern const struct Sensor buttons;
-
-extern const struct Sensor mode_change;    // structure of info for a given  
+extern const struct Sensor buttons;      // elements B1, B2, B3, B4
+extern const struct Sensor mode_change;  // elements "-", "+"
+
+//****** GUARD CHANNEL *********************************************************
+// Is a guard (common-mode reference) element used?  A guard element is an 
+// electrode that is not touched in normal use, so any shift in its counts is
+// common to the whole panel (e.g. a water film).  When defined, a Sensor can
+// name a single element guard Sensor and the guard delta is subtracted from,
+// and/or used to gate, the deltas of the Sensor's own elements.  The guard
+// element needs its own entry in TOTAL_NUMBER_OF_ELEMENTS.
+//#define GUARD_CHANNEL
+
+#ifdef GUARD_CHANNEL
+extern const struct Element guard_element; // structure containing guard element
+extern const struct Sensor guard;          // single element guard sensor
+#endif
 
 //****** RAM ALLOCATION ********************************************************
 // TOTAL_NUMBER_OF_ELEMENTS represents the total number of elements used, even if 
 // they are going to be segmented into seperate groups.  This defines the 
 // RAM allocation for the baseline tracking.  If only the TI_CAPT_Raw function
 // is used, then this definition should be removed to conserve RAM space.
+#ifdef GUARD_CHANNEL
+#define TOTAL_NUMBER_OF_ELEMENTS 7
+#else
 #define TOTAL_NUMBER_OF_ELEMENTS 6
+#endif
 // If the RAM_FOR_FLASH definition is removed, then the appropriate HEAP size 
 // must be allocated. 2 bytes * MAXIMUM_NUMBER_OF_ELEMENTS_PER_SENSOR + 2 bytes
 // of overhead.
@@ -55,29 +74,63 @@ extern const struct Sensor mode_change;    // structure of info for a given
 // RAM_FOR_FLASH is defined, then this also defines the amount of RAM space
 // allocated (global variable) for computations.
 #define MAXIMUM_NUMBER_OF_ELEMENTS_PER_SENSOR  4
+//****** Sensor Constants ******************************************************
+// Per sensor values derived from structure.c.  GATE_US is the measurement
+// time of one element, SCAN_US the time to measure the whole sensor.
+#define BUTTONS_BASE_OFFSET                  0
+#define BUTTONS_NUM_ELEMENTS                 4
+#define BUTTONS_GATE_US                      64
+#define BUTTONS_SCAN_US                      256
+#define MODE_CHANGE_BASE_OFFSET              4
+#define MODE_CHANGE_NUM_ELEMENTS             2
+#define MODE_CHANGE_GATE_US                  64
+#define MODE_CHANGE_SCAN_US                  128
+#ifdef GUARD_CHANNEL
+#define GUARD_BASE_OFFSET                    6
+#define GUARD_NUM_ELEMENTS                   1
+#define GUARD_GATE_US                        64
+#define GUARD_SCAN_US                        64
+#endif
+//****** RAM USAGE *************************************************************
+// Static RAM of the CTS layer for this board (48 bytes available to the CTS
+// layer, 512 bytes total).  Generated, see tools/structure_gen.py.
+//   without guard:
+//     baseCnt[TOTAL_NUMBER_OF_ELEMENTS]                  12 bytes
+//     ctsStatusReg                                        2 bytes
+//     ctsCalibration                                      2 bytes
+//     measCnt[MAXIMUM_NUMBER_OF_ELEMENTS_PER_SENSOR]      8 bytes
+//     CapTouch_Calibrate() stack                         64 bytes (stack)
+//     static total                                       24 bytes
+//   with GUARD_CHANNEL:
+//     baseCnt[TOTAL_NUMBER_OF_ELEMENTS]                  14 bytes
+//     ctsStatusReg                                        2 bytes
+//     ctsCalibration                                      2 bytes
+//     measCnt[MAXIMUM_NUMBER_OF_ELEMENTS_PER_SENSOR]      8 bytes
+//     CapTouch_Calibrate() stack                         68 bytes (stack)
+//     static total                                       26 bytes
 //****** Choosing a  Measurement Method ****************************************
 // These variables are references to the definitions found in structure.c and
 // must be generated per the application.
 // possible values for the method field
 
 // OSCILLATOR DEFINITIONS
-//#define RO_COMPAp_TA0_WDTp  		64
-#define RO_PINOSC_TA0_WDTp  		65
-//#define RO_PINOSC_TA0       		66
-//#define RO_COMPAp_TA1_WDTp  		67
-//#define RO_COMPB_TA0_WDTA			68
-//#define RO_COMPB_TA1_WDTA         69
+//#define RO_COMPAp_TA0_WDTp      64
+#define RO_PINOSC_TA0_WDTp      65
+//#define RO_PINOSC_TA0           66
+//#define RO_COMPAp_TA1_WDTp      67
+//#define RO_COMPB_TA0_WDTA       68
+//#define RO_COMPB_TA1_WDTA       69
 
 // RC DEFINITIONS
-//#define RC_PAIR_TA0       		01
-         
+//#define RC_PAIR_TA0             1
+
 // FAST RO DEFINITIONS
-//#define fRO_PINOSC_TA0_SW           25
-//#define fRO_COMPB_TA0_SW            26
-//#define fRO_COMPB_TA1_SW            27
-//#define fRO_COMPAp_TA0_SW            28
-//#define fRO_COMPAp_SW_TA0            29
-//#define fRO_COMPAp_TA1_SW            30
+//#define fRO_PINOSC_TA0_SW       25
+//#define fRO_COMPB_TA0_SW        26
+//#define fRO_COMPB_TA1_SW        27
+//#define fRO_COMPAp_TA0_SW       28
+//#define fRO_COMPAp_SW_TA0       29
+//#define fRO_COMPAp_TA1_SW       30
 
 //****** WHEEL and SLIDER ******************************************************
 // Are wheel or slider representations used?
@@ -264,6 +317,11 @@ extern const struct Sensor mode_change;    // structure of info for a given
 #define RO_MASK         0xC0        // 1100 0000
 #define RC_FRO_MASK     0x3F        // 0011 1111
 
+// possible values for the guardMode field
+#define GUARD_SUBTRACT  0x01        // remove the guard delta from each element
+#define GUARD_GATE      0x02        // ignore the sensor while the guard delta
+                                    // is at or above the guard threshold
+
 //******************************************************************************
 // The sensor structure identifies port or comparator input definitions for each
 // sensor.
@@ -392,6 +450,15 @@ struct Sensor{
     
   uint16_t accumulationCycles;
   
+//*****************************************************************************
+// Guard channel definitions
+
+#ifdef GUARD_CHANNEL
+  const struct Sensor *guardSensor; // single element guard sensor, 0 if the
+                                    // sensor is not guarded
+  uint8_t guardMode;                // GUARD_SUBTRACT, GUARD_GATE or both
+#endif
+
 //*****************************************************************************
 // Other definitions
 
@@ -19,15 +19,27 @@ uint8_t CapTouch_isBinaryModeCounter = 0; 	// If true, count the mode LEDs in bi
 uint8_t CapTouch_isModeBtnReleased = 1;		// CapTouch board mode buttons are released/not pressed
 uint8_t CapTouch_isEffectBtnReleased = 1;	// CapTouch board effect (B1-B4) buttons are released/not pressed
 uint8_t CapTouch_isLEDFrozen = 0; 			// CapTouch board colored LEDs lock current state
-uint8_t CapTouch_RandomNumber = 1;			// Random number generated from interrupt
 
 // private variables
 static uint8_t 	repeatEffectEnabled = 0;	// Allow the effect to repeat, used in RepeatOnHoldWait()
-static uint16_t buttonPressCounter = 0;		// Counts the number of button samples
+static uint8_t 	buttonHeld = 0;				// buttonHoldStart is set
+static uint32_t buttonHoldStart;			// Timer_Uptime when the effect button hold began
 static uint16_t repeatModeEnabled = 0;		// Allow the mode button to be held down
-static uint16_t	modePressCounter = 0;		// Counts the number of mode button samples
+static uint8_t 	modeHeld = 0;				// modeHoldStart is set
+static uint32_t	modeHoldStart;				// Timer_Uptime when the mode button hold began, or of the last action
 static uint8_t 	modeIncrementOk = 1; 	    // Flag if the mode can be incremented
 
+// Three clicks in one PWM session, played when the mode counter format changes
+static const SequenceStep tripleClick[] = {
+	{&lra_click, 0},
+	{&lra_click, 0},
+	{&lra_click, 0}
+};
+
+// private functions
+static void CapTouch_CalibrateSensor(const struct Sensor *sensor, uint16_t *threshold, uint16_t *maxResponse);
+static void CapTouch_CalibrationLED(uint8_t referenceNumber, uint8_t on);
+
 /*
  * CapTouch_Init - Initialization settings for captouch evaluation board
  */
@@ -37,11 +49,17 @@ void CapTouch_Init(void)
 	CapTouch_isModeBtnReleased = 1;			// Mode buttons status = mode buttons are released (not pressed)
 	CapTouch_isEffectBtnReleased = 1;			// Effect buttons Status (B1-B4) = effect buttons are released (not pressed)
 
+	TI_CAPT_Load_Calibration();					// Use the measured thresholds if the board has been calibrated
+
 	// Establish Capacitive Touch Baseline
 	TI_CAPT_Init_Baseline(&mode_change);		// Measure initial capacitance of mode buttons
 	TI_CAPT_Init_Baseline(&buttons);			// Measure initial capacitance of effect buttons (B1-B4)
 	TI_CAPT_Update_Baseline(&mode_change,5);	// Measure mode buttons capacitance 5x times and average, this tracks changing capacitance
 	TI_CAPT_Update_Baseline(&buttons,5);		// Measure effect buttons capacitance 5x times and average, this tracks changing capacitance
+#ifdef GUARD_CHANNEL
+	TI_CAPT_Init_Baseline(&guard);				// Measure initial capacitance of the guard (common-mode) element
+	TI_CAPT_Update_Baseline(&guard,5);			// Measure guard capacitance 5x times and average
+#endif
 }
 /*
  * CapTouch_PowerUpSequence - visual startup sequence for the evaluation board
@@ -53,10 +71,10 @@ void CapTouch_PowerUpSequence(void)
 	CapTouch_FlashModeLEDs(3);
 
 	// Vibrate LRA
-	Haptics_SendWaveform(lra_rampup);
+	Haptics_QueueWaveform(&lra_rampup, HAPTICS_PRIORITY_LOW);
 
 	// Rotate ERM
-	Haptics_SendWaveform(erm_rampup);
+	Haptics_QueueWaveform(&erm_rampup, HAPTICS_PRIORITY_LOW);
 
 	CapTouch_ButtonLEDOffSequence();
 }
@@ -73,7 +91,7 @@ void CapTouch_IncrementMode(void)
 			CapTouch_IncrementModeCarousel();
 
 		// Vibrate LRA when mode button is pressed
-		Haptics_SendWaveform(lra_tick);
+		Haptics_QueueWaveform(&lra_tick, HAPTICS_PRIORITY_HIGH);
 	}
 }
 /*
@@ -89,7 +107,7 @@ void CapTouch_DecrementMode(void)
 			CapTouch_DecrementModeCarousel();
 
 		// Vibrate LRA when mode button is pressed
-		Haptics_SendWaveform(lra_tick);
+		Haptics_QueueWaveform(&lra_tick, HAPTICS_PRIORITY_HIGH);
 	}
 }
 /*
@@ -100,9 +118,7 @@ void CapTouch_SetBinaryMode()
 	CapTouch_isBinaryModeCounter = 1;
 	CapTouch_mode = 0;
 	Haptics_OutputEnableSet(1);
-	Haptics_SendWaveform(lra_click);
-	Haptics_SendWaveform(lra_click);
-	Haptics_SendWaveform(lra_click);
+	Haptics_SendSequence(tripleClick, sizeof(tripleClick)/sizeof(SequenceStep), HAPTICS_PRIORITY_NORMAL);
 	Haptics_OutputEnableSet(0);
 }
 /*
@@ -113,9 +129,7 @@ void CapTouch_UnsetBinaryMode()
 	CapTouch_isBinaryModeCounter = 0;
 	CapTouch_mode = 0;
 	Haptics_OutputEnableSet(1);
-	Haptics_SendWaveform(lra_click);
-	Haptics_SendWaveform(lra_click);
-	Haptics_SendWaveform(lra_click);
+	Haptics_SendSequence(tripleClick, sizeof(tripleClick)/sizeof(SequenceStep), HAPTICS_PRIORITY_NORMAL);
 	Haptics_OutputEnableSet(0);
 }
 /*
@@ -320,7 +334,7 @@ void CapTouch_RepeatOnHold(void)
 	CapTouch_isEffectBtnReleased = 1;		// indicate the button has been released
 }
 /*
- * CapTouch_RepeatOnHoldWait - hold button and wait X ms before playing repeat waveform
+ * CapTouch_RepeatOnHoldWait - hold button and wait HOLDREPEATDELAY before playing repeat waveform
  */
 void CapTouch_RepeatOnHoldWait(void)
 {
@@ -329,9 +343,13 @@ void CapTouch_RepeatOnHoldWait(void)
 	if(!repeatEffectEnabled)
 	{
 		Haptics_OutputEnableSet(0);				// disable haptics output
-		buttonPressCounter++;
+		if(!buttonHeld)
+		{
+			buttonHeld = 1;
+			buttonHoldStart = Timer_Uptime();
+		}
 
-		if(buttonPressCounter > 60)				// sets the time to wait
+		if(Timer_Uptime() - buttonHoldStart >= HOLDREPEATDELAY)
 		{
 			repeatEffectEnabled = 1;
 			Haptics_OutputEnableSet(1);
@@ -350,12 +368,15 @@ void CapTouch_EnableOnHold(void (*action)())
 	{
 		Haptics_OutputEnableSet(0);			// disable haptics output
 		modeIncrementOk = 0; 				// disable mode increment
-		modePressCounter++;
-
-		if(modePressCounter > 80)			// sets the time to wait
+		if(!modeHeld)
 		{
+			modeHeld = 1;
+			modeHoldStart = Timer_Uptime();
+		}
 
-			modePressCounter = 1;
+		if(Timer_Uptime() - modeHoldStart >= HOLDACTIONDELAY)
+		{
+			modeHoldStart = Timer_Uptime();	// repeat while held
 			(*action)();
 			CapTouch_FlashModeLEDs(1);
 		}
@@ -381,7 +402,7 @@ void CapTouch_UnfreezeLEDs(void)
 void CapTouch_RepeatReset(void)
 {
 	repeatEffectEnabled = 0;
-	buttonPressCounter = 0;
+	buttonHeld = 0;
 	Haptics_OutputEnableSet(1);
 }
 /**
@@ -390,7 +411,157 @@ void CapTouch_RepeatReset(void)
 void CapTouch_ModeRepeatReset(void)
 {
 	repeatModeEnabled = 0;
-	modePressCounter = 0;
+	modeHeld = 0;
 	modeIncrementOk = 1;
 	//Haptics_OutputEnableSet(1);
 }
+/**
+ * CapTouch_Calibrate - guided measurement of threshold and maxResponse for every
+ * 		button, stored in INFO flash and used by the CTS layer
+ */
+void CapTouch_Calibrate(void)
+{
+	uint16_t threshold[TOTAL_NUMBER_OF_ELEMENTS] = {0};		// 0 = keep structure.c value
+	uint16_t maxResponse[TOTAL_NUMBER_OF_ELEMENTS] = {0};
+
+	printf("Calibration - touch each button while its LED is on\r\n");
+
+	CapTouch_CalibrateSensor(&buttons, threshold, maxResponse);
+	CapTouch_CalibrateSensor(&mode_change, threshold, maxResponse);
+
+	if(TI_CAPT_Save_Calibration(threshold, maxResponse))
+		printf("Calibration saved\r\n");
+	else
+		printf("Calibration NOT saved\r\n");
+
+	CapTouch_Init();							// Re-establish baseline with the new values
+}
+/*
+ * CapTouch_CalibrateSensor - measure noise and touch response of each element in a sensor
+ * @param sensor - sensor to calibrate
+ * @param threshold - calibrated thresholds, indexed by baseOffset + element
+ * @param maxResponse - calibrated maximum responses, indexed by baseOffset + element
+ */
+static void CapTouch_CalibrateSensor(const struct Sensor *sensor, uint16_t *threshold, uint16_t *maxResponse)
+{
+	uint16_t counts[MAXIMUM_NUMBER_OF_ELEMENTS_PER_SENSOR];
+	uint16_t base[MAXIMUM_NUMBER_OF_ELEMENTS_PER_SENSOR];
+	uint16_t noise[MAXIMUM_NUMBER_OF_ELEMENTS_PER_SENSOR];
+	uint32_t sum[MAXIMUM_NUMBER_OF_ELEMENTS_PER_SENSOR];
+	uint16_t delta, peak;
+	uint32_t start;
+	uint8_t i, j, touched;
+
+	// Baseline and noise, nothing touched
+	printf("Do not touch\r\n");
+	sleep(6 * LEDBLINKDELAY);
+	for(j = 0; j < sensor->numElements; j++)
+	{
+		sum[j] = 0;
+		noise[j] = 0;
+	}
+	for(i = 0; i < CALIBRATIONSAMPLES; i++)
+	{
+		TI_CAPT_Raw(sensor, counts);
+		for(j = 0; j < sensor->numElements; j++)
+			sum[j] += counts[j];
+		sleep(CALIBRATIONDELAY);
+	}
+	for(j = 0; j < sensor->numElements; j++)
+		base[j] = sum[j] / CALIBRATIONSAMPLES;
+	for(i = 0; i < CALIBRATIONSAMPLES; i++)
+	{
+		TI_CAPT_Raw(sensor, counts);
+		for(j = 0; j < sensor->numElements; j++)
+		{
+			delta = (counts[j] > base[j]) ? counts[j] - base[j] : base[j] - counts[j];
+			if(delta > noise[j])
+				noise[j] = delta;
+		}
+		sleep(CALIBRATIONDELAY);
+	}
+
+	// Touch response, RO counts fall when an element is touched
+	for(j = 0; j < sensor->numElements; j++)
+	{
+		printf("Touch element ");
+		Uart_PrintNumber(sensor->baseOffset + j);
+		printf("\r\n");
+		CapTouch_CalibrationLED((sensor->arrayPtr[j])->referenceNumber, 1);
+
+		peak = 0;
+		touched = 0;
+		start = Timer_Uptime();
+		while(!touched && (Timer_Uptime() - start < CALIBRATIONTIMEOUT))	// wait for the touch
+		{
+			TI_CAPT_Raw(sensor, counts);
+			delta = (base[j] > counts[j]) ? base[j] - counts[j] : 0;
+			if((delta > 4*noise[j]) && (delta >= CALIBRATIONMINDELTA))
+				touched = 1;
+			else
+				sleep(CALIBRATIONDELAY);
+		}
+		if(touched)
+		{
+			for(i = 0; i < CALIBRATIONSAMPLES; i++)				// record the peak response
+			{
+				TI_CAPT_Raw(sensor, counts);
+				delta = (base[j] > counts[j]) ? base[j] - counts[j] : 0;
+				if(delta > peak)
+					peak = delta;
+				sleep(CALIBRATIONDELAY);
+			}
+		}
+
+		CapTouch_CalibrationLED((sensor->arrayPtr[j])->referenceNumber, 0);
+
+		if(peak)
+		{
+			// Threshold half way to the peak, but well clear of the noise
+			threshold[sensor->baseOffset + j] = peak / 2;
+			if(threshold[sensor->baseOffset + j] < 2*noise[j] + 1)
+				threshold[sensor->baseOffset + j] = 2*noise[j] + 1;
+			// (maxResponse - threshold) must be between 1 and 655, see Dominant_Element()
+			if(peak > threshold[sensor->baseOffset + j] + 655)
+				peak = threshold[sensor->baseOffset + j] + 655;
+			if(peak <= threshold[sensor->baseOffset + j])
+				peak = threshold[sensor->baseOffset + j] + 1;
+			maxResponse[sensor->baseOffset + j] = peak;
+
+			printf("threshold ");
+			Uart_PrintNumber(threshold[sensor->baseOffset + j]);
+			printf(" maxResponse ");
+			Uart_PrintNumber(maxResponse[sensor->baseOffset + j]);
+			printf(" noise ");
+			Uart_PrintNumber(noise[j]);
+			printf("\r\nRelease\r\n");
+			sleep(6 * LEDBLINKDELAY);
+		}
+		else
+		{
+			printf("No touch, keeping default\r\n");
+		}
+	}
+}
+/*
+ * CapTouch_CalibrationLED - show which element is being calibrated
+ * @param referenceNumber - element reference number (button bit)
+ * @param on - 1 to light the LED, 0 to turn it off
+ */
+static void CapTouch_CalibrationLED(uint8_t referenceNumber, uint8_t on)
+{
+	if(referenceNumber & BUTTON_MASK)
+	{
+		if(on)
+			P1OUT |= referenceNumber;			// button LED
+		else
+			P1OUT &= ~referenceNumber;
+	}
+	else
+	{
+		if(on)
+			CapTouch_ModeLEDsOn();				// mode buttons have no LED of their own
+		else
+			CapTouch_ModeLEDsOff();
+	}
+}
@@ -18,6 +18,7 @@
 #include "msp430.h"
 #include "CTS/structure.h"
 #include "Timer.h"
+#include "Uart.h"
 
 // Button Definitions
 #define BUTTON_MASK   (BUTTON1+BUTTON2+BUTTON3+BUTTON4)		// Button Mask
@@ -39,7 +40,17 @@
 #define BUTTONMINUS BIT4									// Mode Button -
 #define BUTTONPLUS  BIT5									// Mode Button +
 
-#define LEDBLINKDELAY 1500							// LED blink rate
+#define LEDBLINKDELAY TIMER_COUNTS(250)				// LED blink rate
+
+// Hold Settings, measured on the uptime clock (Timer_Uptime)
+#define HOLDREPEATDELAY 	TIMER_COUNTS(600)		// Effect button hold before the effect repeats
+#define HOLDACTIONDELAY 	TIMER_COUNTS(800)		// Mode button hold before the action, and between actions
+
+// Calibration Settings
+#define CALIBRATIONSAMPLES  16						// Scans used to measure baseline, noise and touch peak
+#define CALIBRATIONDELAY    TIMER_COUNTS(10)			// Time between calibration scans
+#define CALIBRATIONTIMEOUT  TIMER_COUNTS(5000)		// Time to wait for a touch before skipping the element
+#define CALIBRATIONMINDELTA 10						// Minimum touch response accepted (counts)
 
 // Status variables
 extern uint8_t 	CapTouch_mode; 						// Current mode, show on mode LEDs
@@ -47,7 +58,6 @@ extern uint8_t  CapTouch_isBinaryModeCounter; 		// If true, count the mode LEDs
 extern uint8_t 	CapTouch_isModeBtnReleased;	   	 	// CapTouch board mode buttons are released/not pressed
 extern uint8_t 	CapTouch_isEffectBtnReleased;		// CapTouch board effect (B1-B4) buttons are released/not pressed
 extern uint8_t  CapTouch_isLEDFrozen;				// CapTouch board colored LEDs lock current state
-extern uint8_t 	CapTouch_RandomNumber; 				// Random number generated from interrupt
 
 /**
  * CapTouch_Init - Initialization settings for captouch evaluation board
@@ -56,7 +66,7 @@ void CapTouch_Init(void);
 
 /**
  * CapTouch_PowerUpSequence - visual startup sequence for the evaluation board
- * @TODO - Update this function when changing actuators types (ERM, LRA, Piezo)
+ * 		(plays lra_rampup and erm_rampup, Haptics_SetPiezo plays them on a piezo)
  */
 void CapTouch_PowerUpSequence(void);
 
@@ -191,4 +201,10 @@ void CapTouch_RepeatReset(void);
  */
 void CapTouch_ModeRepeatReset(void);
 
+/**
+ * CapTouch_Calibrate - guided measurement of threshold and maxResponse for every
+ * 		button, stored in INFO flash and used by the CTS layer
+ */
+void CapTouch_Calibrate(void);
+
 #endif /* CAPTOUCHBOARD_H_ */
@@ -0,0 +1,153 @@
+/******************************************************************************
+ * Drv2605.c
+ *
+ * Created on: Oct 19, 2026
+ * Board: DRV2603EVM-CT RevD
+ *
+ * Desc: This file contains the output backend for an I2C haptic driver with
+ * 		an effect library (DRV2605 class) on USCI_B0, see Haptics_SetBackend.
+ * 		Waveforms are played in real-time playback (RTP) mode: the player
+ * 		keeps the timing and writes each amplitude to the RTP register.
+ * 		Library effects are started with a few register writes and then run
+ * 		on the driver by itself.  LRA_AUTOOFF uses the driver's open loop
+ * 		drive, the player does not make the carrier.
+ *
+ * 		Start, stop and output run in the TIMER1_A0 ISR and queue their
+ * 		writes with I2c_Post, output only posts changed RTP values.  Mode and
+ * 		effect block for several transfers (~0.3ms each at I2C_BITRATE), the
+ * 		player calls them from thread context (isrMode = 0).
+ *
+ ******************************************************************************/
+
+#include "Drv2605.h"
+
+// private variables
+static uint8_t rtpValue;			// last value written to DRV2605_RTP
+
+// private functions
+static void Drv2605_Mode(uint8_t outputMode);
+static void Drv2605_Start(void);
+static void Drv2605_Stop(void);
+static void Drv2605_Output(uint8_t level, uint8_t drive);
+static uint8_t Drv2605_Effect(uint8_t effect);
+static void Drv2605_Update(uint8_t reg, uint8_t mask, uint8_t value);
+
+// public variables
+const Backend Drv2605_backend = {Drv2605_Mode, Drv2605_Start, Drv2605_Stop, Drv2605_Output, Drv2605_Effect, 0, 0};
+
+/**
+ * Drv2605_Init - set up the I2C bus and look for the driver, leaves it in
+ * 		standby with signed RTP data
+ * @return uint8_t - 1 if a DRV2605 or DRV2605L answered, 0 if not
+ */
+uint8_t Drv2605_Init(void)
+{
+	uint8_t status;
+
+	I2c_Init(Haptics_smclkHz);
+	if(!I2c_ReadRegister(DRV2605_ADDRESS, DRV2605_STATUS, &status))
+		return 0;
+
+	status >>= 5;
+	if((status != DRV2605_DEVICEID_2605) && (status != DRV2605_DEVICEID_2605L))
+		return 0;					// DRV2604 parts have RAM instead of the library
+
+	I2c_WriteRegister(DRV2605_ADDRESS, DRV2605_MODE, DRV2605_MODE_STANDBY);
+	Drv2605_Update(DRV2605_CONTROL3, DRV2605_DATA_UNSIGNED, 0);	// RTP 0 = no drive, negative = brake
+	return 1;
+}
+
+/*
+ * Drv2605_Mode - select the actuator type, loop mode and library
+ * @param uint8_t outputMode - LRA_AUTOON, LRA_AUTOOFF or ERM
+ */
+static void Drv2605_Mode(uint8_t outputMode)
+{
+	uint16_t period;
+
+	switch(outputMode)
+	{
+	case LRA_AUTOOFF: 	// LRA open loop at Haptics_dumbModeTick
+		period = Haptics_dumbModeTick / 4;		// Period in us, the half period is in 8MHz cycles
+		I2c_WriteRegister(DRV2605_ADDRESS, DRV2605_OLPERIOD, (uint8_t) (((uint32_t) period * 100 + 4923) / 9846));
+		Drv2605_Update(DRV2605_FEEDBACK, DRV2605_N_ERM_LRA, DRV2605_N_ERM_LRA);
+		Drv2605_Update(DRV2605_CONTROL3, DRV2605_LRA_OPEN_LOOP, DRV2605_LRA_OPEN_LOOP);
+		I2c_WriteRegister(DRV2605_ADDRESS, DRV2605_LIBRARY, DRV2605_LIBRARY_LRA);
+		break;
+	case ERM: 			// ERM Mode
+		Drv2605_Update(DRV2605_FEEDBACK, DRV2605_N_ERM_LRA, 0);
+		I2c_WriteRegister(DRV2605_ADDRESS, DRV2605_LIBRARY, DRV2605_LIBRARY_ERM);
+		break;
+	default:			// LRA with Auto-resonance, also PIEZO (no piezo support)
+		Drv2605_Update(DRV2605_FEEDBACK, DRV2605_N_ERM_LRA, DRV2605_N_ERM_LRA);
+		Drv2605_Update(DRV2605_CONTROL3, DRV2605_LRA_OPEN_LOOP, 0);
+		I2c_WriteRegister(DRV2605_ADDRESS, DRV2605_LIBRARY, DRV2605_LIBRARY_LRA);
+		break;
+	}
+}
+
+/*
+ * Drv2605_Start - leave standby in real-time playback mode with no drive
+ */
+static void Drv2605_Start(void)
+{
+	rtpValue = 0;
+	I2c_Post(DRV2605_ADDRESS, DRV2605_RTP, 0);
+	I2c_Post(DRV2605_ADDRESS, DRV2605_MODE, DRV2605_MODE_RTP);
+}
+
+/*
+ * Drv2605_Stop - no drive, then standby
+ */
+static void Drv2605_Stop(void)
+{
+	rtpValue = 0;
+	I2c_Post(DRV2605_ADDRESS, DRV2605_RTP, 0);
+	I2c_Post(DRV2605_ADDRESS, DRV2605_MODE, DRV2605_MODE_STANDBY);
+}
+
+/*
+ * Drv2605_Output - write a PWM duty cycle as signed RTP data, 0x80 -> 0,
+ * 		0xFF -> 127 (full drive), 0x00 -> -128 (full brake)
+ * @param uint8_t level - PWM duty cycle, 0x80 = no drive
+ * @param uint8_t drive - 0 outputs no drive
+ */
+static void Drv2605_Output(uint8_t level, uint8_t drive)
+{
+	uint8_t value = drive ? (level ^ 0x80) : 0;
+
+	if(value == rtpValue)
+		return;
+	if(I2c_Post(DRV2605_ADDRESS, DRV2605_RTP, value))
+		rtpValue = value;						// Else tried again at the next output
+}
+
+/*
+ * Drv2605_Effect - play one library effect with the internal trigger
+ * @param uint8_t effect - library effect, 1 to DRV2605_EFFECTS
+ * @return uint8_t - 1 if the effect was started
+ */
+static uint8_t Drv2605_Effect(uint8_t effect)
+{
+	if(!effect || (effect > DRV2605_EFFECTS))
+		return 0;
+
+	return I2c_WriteRegister(DRV2605_ADDRESS, DRV2605_MODE, DRV2605_MODE_INTERNAL)
+			&& I2c_WriteRegister(DRV2605_ADDRESS, DRV2605_WAVESEQ1, effect)
+			&& I2c_WriteRegister(DRV2605_ADDRESS, DRV2605_WAVESEQ2, 0)
+			&& I2c_WriteRegister(DRV2605_ADDRESS, DRV2605_GO, 1);
+}
+
+/*
+ * Drv2605_Update - read, modify and write register bits
+ * @param uint8_t reg - register address
+ * @param uint8_t mask - bits to change
+ * @param uint8_t value - new value of the bits
+ */
+static void Drv2605_Update(uint8_t reg, uint8_t mask, uint8_t value)
+{
+	uint8_t data;
+
+	if(I2c_ReadRegister(DRV2605_ADDRESS, reg, &data))
+		I2c_WriteRegister(DRV2605_ADDRESS, reg, (data & ~mask) | (value & mask));
+}
@@ -0,0 +1,59 @@
+/******************************************************************************
+ * Drv2605.h
+ *
+ * Created on: Oct 19, 2026
+ * Board: DRV2603EVM-CT RevD
+ *
+ * Desc: This file contains the output backend for an I2C haptic driver with
+ * 		an effect library (DRV2605 class) on USCI_B0, see Haptics_SetBackend.
+ * 		Waveforms are played in real-time playback (RTP) mode: the player
+ * 		keeps the timing and writes each amplitude to the RTP register.
+ * 		Library effects are started with a few register writes and then run
+ * 		on the driver by itself.  LRA_AUTOOFF uses the driver's open loop
+ * 		drive, the player does not make the carrier.
+ *
+ ******************************************************************************/
+
+#ifndef DRV2605_H_
+#define DRV2605_H_
+
+#include "Haptics.h"
+#include "I2c.h"
+
+#define DRV2605_ADDRESS		0x5A	// 7 bit I2C address
+
+// Registers
+#define DRV2605_STATUS		0x00	// DEVICE_ID in bits 7-5
+#define DRV2605_MODE		0x01	// STANDBY bit 6, MODE bits 2-0
+#define DRV2605_RTP			0x02	// Real-time playback input
+#define DRV2605_LIBRARY		0x03	// Waveform library selection
+#define DRV2605_WAVESEQ1	0x04	// Waveform sequencer, 8 registers, 0 ends the sequence
+#define DRV2605_WAVESEQ2	0x05
+#define DRV2605_GO			0x0C	// Bit 0 starts the sequence
+#define DRV2605_FEEDBACK	0x1A	// N_ERM_LRA bit 7
+#define DRV2605_CONTROL3	0x1D	// DATA_FORMAT_RTP bit 3, LRA_OPEN_LOOP bit 0
+#define DRV2605_OLPERIOD	0x20	// Open loop LRA period, 98.46us units (DRV2605L)
+
+// Register values
+#define DRV2605_DEVICEID_2605	3		// DEVICE_ID of the DRV2605
+#define DRV2605_DEVICEID_2605L	7		// DEVICE_ID of the DRV2605L
+#define DRV2605_MODE_INTERNAL	0x00	// Internal trigger, GO plays the sequencer
+#define DRV2605_MODE_RTP		0x05	// Real-time playback
+#define DRV2605_MODE_STANDBY	0x40
+#define DRV2605_N_ERM_LRA		0x80
+#define DRV2605_DATA_UNSIGNED	0x08
+#define DRV2605_LRA_OPEN_LOOP	0x01
+#define DRV2605_LIBRARY_ERM		1		// ERM library A
+#define DRV2605_LIBRARY_LRA		6		// LRA library
+#define DRV2605_EFFECTS			123		// Library effects 1-123
+
+extern const Backend Drv2605_backend;
+
+/**
+ * Drv2605_Init - set up the I2C bus and look for the driver, leaves it in
+ * 		standby with signed RTP data
+ * @return uint8_t - 1 if a DRV2605 or DRV2605L answered, 0 if not
+ */
+uint8_t Drv2605_Init(void);
+
+#endif /* DRV2605_H_ */
@@ -0,0 +1,82 @@
+/******************************************************************************
+ * Flash.c
+ *
+ * Created on: Oct 19, 2026
+ * Board: DRV2603EVM-CT RevD
+ *
+ * Desc: This file contains functions for erasing and writing the on-chip
+ * 		flash (INFO segments and reserved main-flash segments) at run time.
+ * 		Interrupts are held off while the flash controller is busy, the CPU
+ * 		is stalled during each erase/write when executing from flash.
+ *
+ ******************************************************************************/
+
+#include "Flash.h"
+
+// private variables
+static uint16_t flashClock = FLASH_CLOCK_8MHZ;	// FCTL2 timing generator setting
+
+/**
+ * Flash_Init - set the timing generator divider for the MCLK frequency
+ * @param uint32_t mclkHz - MCLK frequency, 1MHz-16MHz
+ */
+void Flash_Init(uint32_t mclkHz)
+{
+	// Round the divider up so the generator never runs above FLASH_FTG_HZ,
+	// from 1MHz up it stays above 257kHz
+	uint32_t divider = (mclkHz + FLASH_FTG_HZ - 1) / FLASH_FTG_HZ;
+
+	if(divider < 1)
+		divider = 1;
+	if(divider > 64)
+		divider = 64;						// FN0-FN5 divide by 1 to 64
+	flashClock = FSSEL_1 + (uint16_t) (divider - 1);
+}
+
+/**
+ * Flash_EraseSegment - erase the flash segment containing an address
+ * @param uint8_t *segment - any address within the segment
+ */
+void Flash_EraseSegment(uint8_t *segment)
+{
+	uint16_t contextSaveSR = __get_SR_register();
+
+	__disable_interrupt();
+	FCTL2 = FWKEY + flashClock;		// Flash timing generator
+	FCTL3 = FWKEY;						// Clear LOCK (LOCKA unchanged)
+	FCTL1 = FWKEY + ERASE;				// Segment erase
+	*segment = 0;						// Dummy write starts the erase
+	while(FCTL3 & BUSY);
+	FCTL1 = FWKEY;						// Clear ERASE
+	FCTL3 = FWKEY + LOCK;				// Lock flash
+
+	__bis_SR_register(contextSaveSR & GIE);
+}
+
+/**
+ * Flash_Write - write bytes to erased flash
+ * @param uint8_t *address - flash destination
+ * @param const uint8_t *data - source data
+ * @param uint16_t length - number of bytes to write
+ */
+void Flash_Write(uint8_t *address, const uint8_t *data, uint16_t length)
+{
+	uint16_t i;
+	uint16_t contextSaveSR = __get_SR_register();
+
+	__disable_interrupt();
+	FCTL2 = FWKEY + flashClock;		// Flash timing generator
+	FCTL3 = FWKEY;						// Clear LOCK (LOCKA unchanged)
+	FCTL1 = FWKEY + WRT;				// Byte write
+
+	for(i = 0; i < length; i++)
+	{
+		address[i] = data[i];
+		while(FCTL3 & BUSY);
+	}
+
+	FCTL1 = FWKEY;						// Clear WRT
+	FCTL3 = FWKEY + LOCK;				// Lock flash
+
+	__bis_SR_register(contextSaveSR & GIE);
+}
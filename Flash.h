@@ -0,0 +1,53 @@
+/******************************************************************************
+ * Flash.h
+ *
+ * Created on: Oct 19, 2026
+ * Board: DRV2603EVM-CT RevD
+ *
+ * Desc: This file contains functions for erasing and writing the on-chip
+ * 		flash (INFO segments and reserved main-flash segments) at run time.
+ *
+ ******************************************************************************/
+
+#ifndef FLASH_H_
+#define FLASH_H_
+
+#include "msp430.h"
+#include <stdint.h>
+
+// INFO flash segments (see lnk_msp430g2553.cmd)
+// Note: INFOA holds the DCO calibration constants and must never be erased
+#define FLASH_INFOB		((uint8_t *) 0x1080)	// INFOB segment, 64 bytes
+#define FLASH_INFOC		((uint8_t *) 0x1040)	// INFOC segment, 64 bytes
+#define FLASH_INFOD		((uint8_t *) 0x1000)	// INFOD segment, 64 bytes
+
+// Reserved main flash (WAVESTORE in lnk_msp430g2553.cmd), kept out of FLASH
+#define FLASH_WAVESTORE		((uint8_t *) 0xC000)	// Two 512 byte segments, see WaveformStore.c
+#define FLASH_SEGMENTSIZE	512						// Main flash segment size
+
+// Flash timing generator, must be 257kHz - 476kHz.  Flash_Init divides MCLK
+// down to FLASH_FTG_HZ or just below, until then the 8MHz divider is used.
+#define FLASH_FTG_HZ		400000UL				// Target timing generator frequency
+#define FLASH_CLOCK_8MHZ	(FSSEL_1 + FN4 + FN1 + FN0)	// MCLK = 8MHz, 8MHz / (19 + 1) = 400kHz
+
+/**
+ * Flash_Init - set the timing generator divider for the MCLK frequency, call
+ * 		after the DCO is set up and whenever it changes
+ * @param uint32_t mclkHz - MCLK frequency, 1MHz-16MHz
+ */
+void Flash_Init(uint32_t mclkHz);
+/**
+ * Flash_EraseSegment - erase the flash segment containing an address
+ * @param uint8_t *segment - any address within the segment
+ */
+void Flash_EraseSegment(uint8_t *segment);
+
+/**
+ * Flash_Write - write bytes to erased flash
+ * @param uint8_t *address - flash destination
+ * @param const uint8_t *data - source data
+ * @param uint16_t length - number of bytes to write
+ */
+void Flash_Write(uint8_t *address, const uint8_t *data, uint16_t length);
+
+#endif /* FLASH_H_ */
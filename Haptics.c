@@ -6,110 +6,1554 @@
  * Author: a0866685
  *
  * Description: This file contains the functions for sending haptics waveforms.
- * 		Edit this file when changing actuators.
- *
- * @TODO - Update this file when changing between actuators types
- * 			(ERM, LRA, Piezo)
+ * 		Each waveform selects its actuator type (LRA_AUTOON, LRA_AUTOOFF,
+ * 		ERM or PIEZO), the board pins for each type are set in Pwm_Mode.
  *
  * a type of unsigned integer of length 8 bits = unit8_t
  ******************************************************************************/
 #include "Haptics.h"
+#include "Actuator_Waveforms.h"
+#include "Supply.h"
 
 // private variables
-static uint8_t  j,k;
 static uint8_t 	playEffect = 1;		// if 1 = play, 0 = do not play
+static uint8_t 	globalIntensity = HAPTICS_INTENSITY_FULL;	// drive scale of all waveforms
+static uint8_t 	actuatorIntensity[HAPTICS_MODES] = {	// drive scale per output mode
+		HAPTICS_INTENSITY_FULL, HAPTICS_INTENSITY_FULL, HAPTICS_INTENSITY_FULL, HAPTICS_INTENSITY_FULL};
+static const uint8_t modeMax[HAPTICS_MODES] = {LRA_AUTOON_MAX, LRA_AUTOOFF_MAX, ERM_MAX, PIEZO_MAX};
+static uint8_t 	piezoOnly;			// play every waveform in PIEZO mode
+static uint8_t 	pwmPiezo;			// Pwm_Mode selected the piezo driver
+static uint8_t 	supplyCompensation = 1;	// scale the drive by HAPTICS_VCC_NOMINAL / VCC
+static uint8_t 	supplyScale = HAPTICS_INTENSITY_FULL;	// drive scale from the last VCC measurement
+static uint8_t 	supplyMax = 0xFF;	// amplitude limit from the last VCC measurement
+static uint16_t supplyAge;			// ticks since the last VCC measurement
+static uint8_t 	supplyPending;		// a measurement under load is in progress, see Haptics_SupplyTick
+static uint32_t thermalEnergy;		// squared drive integrated over ticks, decaying
+static uint32_t thermalLimit = (uint32_t) HAPTICS_THERMAL_BUDGET * HAPTICS_THERMAL_BUDGET << HAPTICS_THERMAL_SHIFT;
+static uint8_t 	thermalState;		// HAPTICS_THERMAL_OK, _THROTTLED or _REFUSING
+static volatile uint8_t thermalCooling;	// TA1 counts ACLK for the idle model, see Haptics_CoolStart
+static uint16_t thermalCoolCounts;		// ACLK counts per cooling step
+static uint16_t thermalStreamPeriods;	// PWM periods of streamed samples not yet counted as a tick
+
+// player state, shared with the TIMER1_A0 ISR
+static const uint8_t* volatile playData;	// next (amplitude, time) pair
+static volatile uint8_t  playBytes;			// data bytes left after the current pair
+static volatile uint8_t  playTicks;			// ticks left in the current pair
+static uint8_t  playSegments;				// data uses segment escapes (HAPTICS_SEGMENTS)
+static uint8_t  playRamp;					// current pair is a ramp
+static const uint8_t* playLoopStart;		// first byte of the loop body
+static uint8_t  playLoopBytes;				// size of the loop body
+static uint8_t  playLoopEnd;				// playBytes at the end of the loop body
+static uint8_t  playLoopCount;				// loop passes left after the current one
+static const uint8_t* playReturn;			// data after the call, 0 = not in a segment
+static uint8_t  playReturnBytes;			// playBytes after the call
+static const uint8_t* playCallerStart;		// loop of the caller, restored after the segment
+static uint8_t  playCallerBytes;
+static uint8_t  playCallerEnd;
+static uint8_t  playCallerCount;
+static const Envelope* playEnvelope;		// envelope of the playing waveform, 0 = table data
+static uint8_t  playEnvStage;				// next envelope stage, attack = 0
+static uint8_t  playEnvRepeat;				// envelope repeats left
+static uint8_t  playRampTarget;				// amplitude at the end of the ramp
+static uint16_t playRampLevel;				// ramp amplitude, 8.8 fixed point
+static int16_t  playRampStep;				// ramp change per tick, 8.8 fixed point
+static volatile uint16_t playPeriods;		// PWM periods left in the current tick
+static uint16_t playTickPeriods;			// whole PWM periods per tick (stream: per sample)
+static uint16_t playTickFraction;			// accumulated tickRemainder, 1/256 PWM period
+static uint16_t playHalfPeriod;				// LRA_AUTOOFF or PIEZO carrier half period in SMCLK cycles
+static uint16_t playCarrier;				// SMCLK cycles into the carrier half period
+static uint8_t  playPhase;					// carrier half, 0 = amplitude, 1 = 255 - amplitude
+static uint8_t  playLevel;					// amplitude of the current pair
+static uint8_t  playDrive;					// the amplifier is enabled for playLevel
+static uint8_t  playMode;					// output mode of the playing waveform
+static uint8_t  playScale;					// drive scale of the playing waveform, 128 = 1
+static uint8_t  playMax;					// amplitude limit of the playing waveform
+static uint8_t  playStop;					// stop the PWM when the waveform ends
+static uint8_t  playPriority;				// priority of the playing waveform
+static uint8_t  playGap;					// ticks of silence after the waveform
+static const SequenceStep* playSteps;		// next step of the playing sequence
+static uint8_t  playStepsLeft;				// sequence steps left
+static uint8_t  hardwareMode = 0xFF;		// output mode set by Haptics_HardwareMode
+static const Backend* backend = &Haptics_pwmBackend;	// output of the player
+static uint8_t  playStream;					// the player outputs streamed samples
+static volatile uint8_t playBusy;			// a waveform is playing or queued
+static volatile uint8_t playWaiting;		// Haptics_WaitDone is sleeping
+
+// sample stream double buffer, Haptics_StreamByte fills streamBuffer[streamFill]
+// while the player reads the other half
+static uint8_t streamBuffer[2][HAPTICS_STREAMBUFFER];
+static volatile uint8_t streamFill;			// half being filled
+static volatile uint8_t streamFillCount;	// bytes in the half being filled
+static uint8_t streamPlayCount;				// bytes in the half being played
+static uint8_t streamPlayPos;				// next byte to play
+static uint8_t streamPrimed;				// the first buffer has been played
+static volatile uint16_t streamIdle;		// sample periods since the last byte with nothing to play
+
+// queued waveforms, ordered by priority and FIFO within a priority.  The
+// Waveform is copied because callers may pass one built on the stack.  A
+// sequence is queued with outputMode HAPTICS_SEQUENCE, data pointing to the
+// SequenceStep array and length the number of steps.
+#define HAPTICS_SEQUENCE	0xFF
+
+typedef struct Haptics_QueueEntry {
+	const uint8_t* 	data;
+	uint8_t 		outputMode;
+	uint8_t 		length;
+	uint8_t 		priority;
+#ifdef HAPTICS_STATS
+	uint8_t 		id;				// effect ID or HAPTICS_NOID
+	uint32_t 		requested;		// Timer_Uptime when submitted
+#endif
+} QueueEntry;
+
+static QueueEntry queue[HAPTICS_QUEUESIZE];
+static uint8_t queueCount;
+
+#ifdef HAPTICS_STATS
+// playback statistics of the playing waveform, times in Timer_Uptime counts.
+// The uptime runs on ACLK, independent of the player ISR it checks.
+static uint8_t  statsPending;				// waiting for the first output
+static uint8_t  statsActive;				// the playing waveform is recorded
+static uint8_t  statsId;
+static uint32_t statsRequested;
+static uint32_t statsStart;					// first output
+static uint16_t statsLatency;				// us
+static uint16_t statsTicks;					// ticks played
+static uint16_t statsLost;					// PWM periods lost against the uptime, see Haptics_StatsTick
+static volatile uint16_t statsLate;			// late timer steps while playing
+static uint16_t statsTickCounts;			// uptime counts per tick, 8.8 fixed point, 0 = not set yet
+static uint16_t statsPeriodCounts;			// uptime counts per PWM period, 8.8 fixed point
+#endif
+
+// private functions
+static uint8_t Haptics_Submit(QueueEntry* entry);
+static uint8_t Haptics_QueueId(const Waveform* waveform, uint8_t priority, uint8_t id);
+static uint8_t Haptics_Enqueue(const QueueEntry* entry);
+static uint8_t Haptics_Start(const QueueEntry* entry);
+static void Haptics_StartNext(void);
+static uint8_t Haptics_NextStep(void);
+static uint8_t Haptics_Play(const uint8_t* data, uint8_t length, uint8_t outputMode, uint8_t gap);
+static uint8_t Haptics_OutputMode(uint8_t outputMode);
+static void Haptics_ThreadMode(uint8_t outputMode);
+static uint8_t Haptics_Advance(void);
+static uint8_t Haptics_NextPair(void);
+static uint8_t Haptics_NextSegment(void);
+static void Haptics_Escape(uint8_t opcode);
+static void Haptics_Return(void);
+static void Haptics_Ramp(uint8_t amplitude);
+static void Haptics_SetLevel(uint8_t amplitude);
+static void Haptics_Output(void);
+static uint32_t Haptics_DcoFrequency(void);
+static uint8_t Haptics_Scale(uint8_t amplitude);
+static void Haptics_PWMOn(void);
+static void Haptics_SetScale(uint8_t outputMode);
+static uint8_t Haptics_StreamSample(void);
+static void Haptics_Supply(void);
+static uint8_t Haptics_SupplyTick(void);
+static void Haptics_SupplyScale(uint16_t millivolts);
+static void Haptics_Thermal(void);
+static uint8_t Haptics_ThermalTick(void);
+static void Haptics_CoolStart(void);
+static void Haptics_CoolStop(void);
+#ifdef HAPTICS_STATS
+static void Haptics_StatsBegin(void);
+static void Haptics_StatsTick(void);
+static void Haptics_StatsEnd(void);
+static uint32_t Haptics_StatsMicroseconds(uint32_t counts);
+#endif
+static void Pwm_Mode(uint8_t outputMode);
+static void Pwm_Start(void);
+static void Pwm_Stop(void);
+static void Pwm_Output(uint8_t level, uint8_t drive);
 
 // public variables
+const Backend Haptics_pwmBackend = {Pwm_Mode, Pwm_Start, Pwm_Stop, Pwm_Output, 0, 1, 1};
 uint16_t Haptics_dumbModeTick = DUMBTICK;		// Sets the LRA Auto-resonance off frequency (use DUMBTICK above to set frequency)
-uint16_t Haptics_resonantModeTick;
+uint16_t Haptics_piezoModeTick = PIEZOTICK;		// Sets the piezo carrier frequency (use PIEZOTICK above to set frequency)
+uint32_t Haptics_smclkHz = HAPTICS_SMCLK_DEFAULT;
+uint16_t Haptics_vccMillivolts;
+volatile uint16_t Haptics_streamSamples;
+volatile uint16_t Haptics_streamUnderruns;
+volatile uint16_t Haptics_streamOverruns;
+#ifdef HAPTICS_STATS
+PlayStats Haptics_stats[HAPTICS_STATSSIZE];
+#endif
+
+// tick length, set by Haptics_Init
+static uint16_t tickPeriods;				// whole PWM periods per tick
+static uint8_t  tickRemainder;				// SMCLK cycles per tick beyond tickPeriods PWM periods
+static uint16_t dumbTickScale;				// SMCLK / HAPTICS_DUMBTICK_HZ, 8.8 fixed point
 
 /**
- * Haptics_Init - initialize haptics variables and settings
+ * Haptics_Init - initialize haptics variables and settings.  Call after the
+ * 		DCO is set up, the tick length is derived from its frequency.
  */
 void Haptics_Init(void)
 {
-	Haptics_resonantModeTick = (unsigned int) Haptics_dumbModeTick * 2;
+	uint32_t cycles;
+
+	// Haptics_PWMOn selects DIVS_0, so SMCLK is the DCO while the PWM runs
+	Haptics_smclkHz = Haptics_DcoFrequency();
+
+	// SMCLK cycles per tick, split into whole PWM periods of TA1CCR0+1 = 256
+	// cycles and a remainder the player accumulates
+	cycles = ((Haptics_smclkHz / 1000) * HAPTICS_TICK_US + 500) / 1000;
+	tickPeriods = (uint16_t) (cycles >> 8);
+	tickRemainder = (uint8_t) cycles;
+
+	// LRAFREQ_* and Haptics_dumbModeTick are SMCLK cycles at 8MHz
+	dumbTickScale = (uint16_t) (Haptics_smclkHz / (HAPTICS_DUMBTICK_HZ / 256));
+
+	Supply_Init(Haptics_smclkHz);				// MCLK is the DCO too
+}
+
+/*
+ * Haptics_DcoFrequency - find the DCO frequency by comparing the DCO settings
+ * 		with the calibration constants in INFOA
+ * @return uint32_t - frequency in Hz, HAPTICS_SMCLK_DEFAULT if not calibrated
+ */
+static uint32_t Haptics_DcoFrequency(void)
+{
+	uint8_t rsel = BCSCTL1 & 0x0F;
+
+	if((CALBC1_16MHZ != 0xFF) && (rsel == (CALBC1_16MHZ & 0x0F)) && (DCOCTL == CALDCO_16MHZ))
+		return 16000000UL;
+	if((CALBC1_12MHZ != 0xFF) && (rsel == (CALBC1_12MHZ & 0x0F)) && (DCOCTL == CALDCO_12MHZ))
+		return 12000000UL;
+	if((CALBC1_8MHZ != 0xFF) && (rsel == (CALBC1_8MHZ & 0x0F)) && (DCOCTL == CALDCO_8MHZ))
+		return 8000000UL;
+	if((CALBC1_1MHZ != 0xFF) && (rsel == (CALBC1_1MHZ & 0x0F)) && (DCOCTL == CALDCO_1MHZ))
+		return 1000000UL;
+	return HAPTICS_SMCLK_DEFAULT;
 }
 
 /**
- * Haptics_SendWaveform - setup and send haptic waveform
- * @param struct Waveform - the waveform output type, length in bytes, and data)
+ * Haptics_SendWaveform - setup and send haptic waveform with normal priority,
+ * 		returns while the waveform plays (see Haptics_QueueWaveform)
+ * @param Waveform* waveform - the waveform output type, length in bytes, and data
  */
-void Haptics_SendWaveform(const Waveform waveform)
+void Haptics_SendWaveform(const Waveform* waveform)
 {
-	if(playEffect)
-	{
-		Haptics_HardwareMode(waveform.outputMode);	// Set hardware control pins
-		Haptics_StartPWM();							// Start PWM output
+	Haptics_QueueWaveform(waveform, HAPTICS_PRIORITY_NORMAL);
+}
+
+/**
+ * Haptics_QueueWaveform - play a waveform now or queue it behind the playing one
+ * @param Waveform* waveform - the waveform output type, length in bytes, and data
+ * @param uint8_t priority - HAPTICS_PRIORITY_LOW, _NORMAL or _HIGH
+ * @return uint8_t - 1 if the waveform is playing or queued, 0 if it was dropped
+ */
+uint8_t Haptics_QueueWaveform(const Waveform* waveform, uint8_t priority)
+{
+	return Haptics_QueueId(waveform, priority, HAPTICS_NOID);
+}
+
+/**
+ * Haptics_SendEffect - send an effect by ID with normal priority
+ * @param uint8_t id - EFFECT_* ID or a stored waveform ID, EFFECT_USER and above
+ * @return uint8_t - 1 if the effect is playing or queued, 0 if unknown or dropped
+ */
+uint8_t Haptics_SendEffect(uint8_t id)
+{
+	return Haptics_QueueId(Waveforms_Find(id), HAPTICS_PRIORITY_NORMAL, id);
+}
+
+/**
+ * Haptics_QueueEffect - play or queue an effect by ID
+ * @param uint8_t id - EFFECT_* ID or a stored waveform ID, EFFECT_USER and above
+ * @param uint8_t priority - HAPTICS_PRIORITY_LOW, _NORMAL or _HIGH
+ * @return uint8_t - 1 if the effect is playing or queued, 0 if unknown or dropped
+ */
+uint8_t Haptics_QueueEffect(uint8_t id, uint8_t priority)
+{
+	return Haptics_QueueId(Waveforms_Find(id), priority, id);
+}
+
+/*
+ * Haptics_QueueId - play or queue a waveform, see Haptics_QueueWaveform
+ * @param Waveform* waveform - the waveform output type, length in bytes, and data
+ * @param uint8_t priority - HAPTICS_PRIORITY_LOW, _NORMAL or _HIGH
+ * @param uint8_t id - effect ID for the playback statistics, HAPTICS_NOID if none
+ * @return uint8_t - 1 if the waveform is playing or queued, 0 if it was dropped
+ */
+static uint8_t Haptics_QueueId(const Waveform* waveform, uint8_t priority, uint8_t id)
+{
+	QueueEntry entry;
+
+	if(!playEffect || !waveform || (waveform->length < 2))
+		return 0;
+
+	entry.data = waveform->data;
+	entry.outputMode = waveform->outputMode;
+	entry.length = waveform->length;
+	entry.priority = priority;
+#ifdef HAPTICS_STATS
+	entry.id = id;
+#endif
+
+	return Haptics_Submit(&entry);
+}
+
+/**
+ * Haptics_SendSequence - play a list of waveforms, each followed by a gap, in
+ * 		one PWM session.  The sequence is queued like a single waveform.
+ * @param SequenceStep* steps - waveforms and gaps, must stay valid while playing
+ * @param uint8_t count - number of steps
+ * @param uint8_t priority - HAPTICS_PRIORITY_LOW, _NORMAL or _HIGH
+ * @return uint8_t - 1 if the sequence is playing or queued, 0 if it was dropped
+ */
+uint8_t Haptics_SendSequence(const SequenceStep* steps, uint8_t count, uint8_t priority)
+{
+	QueueEntry entry;
+
+	if(!playEffect || !count)
+		return 0;
+
+	entry.data = (const uint8_t*) steps;
+	entry.outputMode = HAPTICS_SEQUENCE;
+	entry.length = count;
+	entry.priority = priority;
+#ifdef HAPTICS_STATS
+	entry.id = HAPTICS_NOID;
+#endif
+
+	return Haptics_Submit(&entry);
+}
+
+/**
+ * Haptics_StreamStart - play PWM samples received by Haptics_StreamByte
+ * @param uint8_t outputMode - LRA_AUTOON, LRA_AUTOOFF or ERM
+ * @param uint8_t periods - sample period in PWM periods of 256 SMCLK cycles
+ * 		(32us at 8MHz), e.g. HAPTICS_STREAMPERIODS
+ * @return uint8_t - 1 if streaming, 0 if play back is disabled or the energy model refuses it
+ */
+uint8_t Haptics_StreamStart(uint8_t outputMode, uint8_t periods)
+{
+	if(!playEffect || !periods)
+		return 0;
+
+	if(HAPTICS_PRIORITY_NORMAL < thermalState)
+		return 0;								// Refused like a normal priority waveform
 
-		Haptics_OutputWaveform(waveform);			// Control the PWM or I2C
+	outputMode = Haptics_OutputMode(outputMode);
+	Haptics_ThreadMode(outputMode);
 
-		Haptics_StopPWM(); 		// Stop PWM output
+	__bic_SR_register(GIE);
+#ifdef HAPTICS_STATS
+	Haptics_StatsEnd();
+#endif
+	if(hardwareMode != outputMode)
+		Haptics_HardwareMode(outputMode);		// Set hardware control pins
+	supplyPending = 0;
+	Supply_Cancel();							// The stream does not poll a measurement under load
+	if(!(TA1CTL & MC_1))
+	{
+		Haptics_Supply();						// Measured without load
+		Haptics_PWMOn();						// Start PWM output
 	}
+
+	// Cancel the playing waveform, queued ones play after the stream
+	playStepsLeft = 0;
+	playGap = 0;
+	playRamp = 0;
+	playMode = outputMode;
+	Haptics_SetScale(outputMode);
+	Haptics_SetLevel(0x80);
+
+	streamFill = 0;
+	streamFillCount = 0;
+	streamPlayCount = 0;
+	streamPlayPos = 0;
+	streamPrimed = 0;
+	streamIdle = 0;
+	Haptics_streamSamples = 0;
+	Haptics_streamUnderruns = 0;
+	Haptics_streamOverruns = 0;
+
+	playTickPeriods = periods;
+	playPeriods = periods;
+	playPhase = 0;
+	playPriority = HAPTICS_PRIORITY_HIGH;
+	playStop = 1;
+	playStream = 1;
+	playBusy = 1;
+	thermalStreamPeriods = 0;
+	TA1CCTL0 &= ~CCIFG;
+	TA1CCTL0 |= CCIE;							// Output samples in the PWM period interrupt
+	__bis_SR_register(GIE);
+
+	return 1;
+}
+
+/**
+ * Haptics_StreamByte - add a sample to the stream, called from the UART RX ISR
+ * @param uint8_t sample - PWM duty cycle, 0x80 = no drive
+ */
+void Haptics_StreamByte(uint8_t sample)
+{
+	if(!playStream)
+		return;
+
+	streamIdle = 0;
+	if(streamFillCount < HAPTICS_STREAMBUFFER)
+		streamBuffer[streamFill][streamFillCount++] = sample;
+	else
+		Haptics_streamOverruns++;				// The player still owns the other half
+}
+
+/**
+ * Haptics_OutputWaveform - control the PWM output pattern, returns when the
+ * 		waveform is done.  The PWM must already be running.
+ * @param Waveform* waveform - the waveform output type, length in bytes, and data
+ */
+void Haptics_OutputWaveform(const Waveform* waveform)
+{
+	Haptics_WaitDone();
+	Haptics_ThreadMode(Haptics_OutputMode(waveform->outputMode));
+	playStop = 0;
+	playStepsLeft = 0;
+	Haptics_Play(waveform->data, waveform->length, waveform->outputMode, 0);
+	Haptics_WaitDone();
+}
+
+/**
+ * Haptics_SetPiezo - play every waveform in PIEZO mode, brake pairs play as
+ * 		no drive.  Takes effect when the next waveform starts.
+ * @param uint8_t enable - 1 = piezo, 0 = the output mode of each waveform
+ */
+void Haptics_SetPiezo(uint8_t enable)
+{
+	piezoOnly = enable;
+}
+
+/**
+ * Haptics_SetIntensity - scale the drive of all waveforms, takes effect when
+ * 		the next waveform starts
+ * @param uint8_t intensity - HAPTICS_INTENSITY_FULL (128) = unscaled, 255 = ~2x
+ */
+void Haptics_SetIntensity(uint8_t intensity)
+{
+	globalIntensity = intensity;
+}
+
+/**
+ * Haptics_SetSupplyCompensation - scale the drive by HAPTICS_VCC_NOMINAL / VCC,
+ * 		takes effect when the PWM next starts
+ * @param uint8_t enable - 1 = compensate, 0 = waveform amplitudes as written
+ */
+void Haptics_SetSupplyCompensation(uint8_t enable)
+{
+	supplyCompensation = enable;
+}
+
+/**
+ * Haptics_SetThermalBudget - limit the energy delivered to the actuator
+ * @param uint8_t drive - sustained drive (amplitude - 0x80) 1-128, 0 = no limit
+ */
+void Haptics_SetThermalBudget(uint8_t drive)
+{
+	__bic_SR_register(GIE);
+	thermalLimit = ((uint32_t) drive * drive) << HAPTICS_THERMAL_SHIFT;
+	Haptics_Thermal();
+	__bis_SR_register(GIE);
+}
+
+/**
+ * Haptics_GetThermalState - get the state of the energy model
+ * @return uint8_t - HAPTICS_THERMAL_OK, _THROTTLED or _REFUSING
+ */
+uint8_t Haptics_GetThermalState(void)
+{
+	return thermalState;
+}
+
+/**
+ * Haptics_GetThermalLoad - get the energy of the model relative to the budget
+ * @return uint8_t - percent of the budget, 255 = 255% or more, 0 with no limit
+ */
+uint8_t Haptics_GetThermalLoad(void)
+{
+	uint32_t energy;
+	uint32_t limit;
+
+	__bic_SR_register(GIE);
+	energy = thermalEnergy;
+	limit = thermalLimit;
+	__bis_SR_register(GIE);
+
+	limit /= 100;
+	if(!limit)
+		return 0;
+	energy /= limit;
+	return (energy > 255) ? 255 : (uint8_t) energy;
+}
+
+/**
+ * Haptics_GetIntensity - get the global intensity
+ * @return uint8_t - intensity, HAPTICS_INTENSITY_FULL = unscaled
+ */
+uint8_t Haptics_GetIntensity(void)
+{
+	return globalIntensity;
 }
 
 /**
- * Haptics_OutputWaveform - control the PWM output pattern
- * @param struct Waveform - the waveform output type, length in bytes, and data
- * @TODO - Modify this function to change actuator types (ERM, LRA, Piezo)
+ * Haptics_SetActuatorIntensity - scale the drive of one output mode
+ * @param uint8_t outputMode - LRA_AUTOON, LRA_AUTOOFF or ERM
+ * @param uint8_t intensity - HAPTICS_INTENSITY_FULL (128) = unscaled, 255 = ~2x
  */
-void Haptics_OutputWaveform(const Waveform waveform)
+void Haptics_SetActuatorIntensity(uint8_t outputMode, uint8_t intensity)
 {
-	switch(waveform.outputMode)
+	outputMode &= HAPTICS_MODE_MASK;
+	if(outputMode < HAPTICS_MODES)
+		actuatorIntensity[outputMode] = intensity;
+}
+
+/**
+ * Haptics_GetActuatorIntensity - get the intensity of one output mode
+ * @param uint8_t outputMode - LRA_AUTOON, LRA_AUTOOFF or ERM
+ * @return uint8_t - intensity, HAPTICS_INTENSITY_FULL = unscaled
+ */
+uint8_t Haptics_GetActuatorIntensity(uint8_t outputMode)
+{
+	outputMode &= HAPTICS_MODE_MASK;
+	if(outputMode < HAPTICS_MODES)
+		return actuatorIntensity[outputMode];
+	return HAPTICS_INTENSITY_FULL;
+}
+
+/**
+ * Haptics_IsBusy - check if a waveform is playing or queued
+ * @return uint8_t - 1 while a waveform is playing, 0 when done
+ */
+uint8_t Haptics_IsBusy(void)
+{
+	return playBusy;
+}
+
+/**
+ * Haptics_WaitDone - sleep in LPM0 until the playing and queued waveforms are done
+ */
+void Haptics_WaitDone(void)
+{
+	__bic_SR_register(GIE);
+	while(playBusy)
 	{
-	case LRA_AUTOON: 	// LRA with Auto-Resonance
-		for(k=0; k < waveform.length; k=k+2)
+		playWaiting = 1;
+		__bis_SR_register(LPM0_bits + GIE);		// Woken by the player ISR
+		__bic_SR_register(GIE);
+	}
+	playWaiting = 0;
+	__bis_SR_register(GIE);
+}
+
+/*
+ * Haptics_Submit - start a waveform or sequence, cancelling a lower priority
+ * 		one, or queue it
+ * @param QueueEntry* entry - waveform or sequence to play
+ * @return uint8_t - 1 if playing or queued, 0 if it was dropped
+ */
+static uint8_t Haptics_Submit(QueueEntry* entry)
+{
+	uint8_t accepted = 1;
+	uint8_t outputMode = entry->outputMode;
+
+	if(outputMode == HAPTICS_SEQUENCE)
+		outputMode = ((const SequenceStep*) entry->data)->waveform->outputMode;
+	Haptics_ThreadMode(Haptics_OutputMode(outputMode));
+
+	if(entry->priority < thermalState)
+		return 0;								// Let the actuator cool down
+
+	__bic_SR_register(GIE);
+#ifdef HAPTICS_STATS
+	entry->requested = Timer_Uptime();
+#endif
+	if(!playBusy || (entry->priority > playPriority))
+	{
+		if(!Haptics_Start(entry))					// Cancels a lower priority waveform
+			Haptics_StartNext();
+	}
+	else
+	{
+		accepted = Haptics_Enqueue(entry);
+	}
+	__bis_SR_register(GIE);
+
+	return accepted;
+}
+
+/*
+ * Haptics_Enqueue - insert a waveform behind all waveforms of equal or higher
+ * 		priority.  When the queue is full the lowest priority waveform is dropped.
+ * @param QueueEntry* entry - waveform to queue
+ * @return uint8_t - 1 if queued, 0 if the new waveform was dropped
+ */
+static uint8_t Haptics_Enqueue(const QueueEntry* entry)
+{
+	uint8_t i;
+
+	if(queueCount == HAPTICS_QUEUESIZE)
+	{
+		if(queue[HAPTICS_QUEUESIZE - 1].priority >= entry->priority)
+			return 0;
+		queueCount--;							// Drop the newest lowest priority waveform
+	}
+
+	for(i = queueCount; i && (queue[i - 1].priority < entry->priority); i--)
+		queue[i] = queue[i - 1];
+	queue[i] = *entry;
+	queueCount++;
+
+	return 1;
+}
+
+/*
+ * Haptics_Start - start a waveform or sequence, replacing the playing one.
+ * 		Called with interrupts disabled.
+ * @param QueueEntry* entry - waveform or sequence to play
+ * @return uint8_t - 1 if playing, 0 if it had nothing to play
+ */
+static uint8_t Haptics_Start(const QueueEntry* entry)
+{
+	playPriority = entry->priority;
+	playStop = 1;
+#ifdef HAPTICS_STATS
+	Haptics_StatsEnd();							// A cancelled waveform ends here
+	statsId = entry->id;
+	statsRequested = entry->requested;
+	statsPending = 1;
+#endif
+
+	if(entry->outputMode == HAPTICS_SEQUENCE)
+	{
+		playSteps = (const SequenceStep*) entry->data;
+		playStepsLeft = entry->length;
+		return Haptics_NextStep();
+	}
+
+	playStepsLeft = 0;
+	return Haptics_Play(entry->data, entry->length, entry->outputMode, 0);
+}
+
+/*
+ * Haptics_StartNext - start the first queued waveform, or stop the PWM and go
+ * 		idle when the queue is empty.  Called with interrupts disabled.
+ */
+static void Haptics_StartNext(void)
+{
+	QueueEntry entry;
+	uint8_t i;
+
+	while(queueCount)
+	{
+		entry = queue[0];
+		queueCount--;
+		for(i = 0; i < queueCount; i++)
+			queue[i] = queue[i + 1];
+
+		if(Haptics_Start(&entry))
+			return;
+	}
+	Haptics_StopPWM();
+	playBusy = 0;
+}
+
+/*
+ * Haptics_NextStep - start the next step of the playing sequence
+ * @return uint8_t - 1 if a step is playing, 0 at the end of the sequence
+ */
+static uint8_t Haptics_NextStep(void)
+{
+	const Waveform* waveform;
+
+	while(playStepsLeft)
+	{
+		playStepsLeft--;
+		waveform = playSteps->waveform;
+		if(Haptics_Play(waveform->data, waveform->length, waveform->outputMode, playSteps->gap))
 		{
-			if(waveform.data[k] == 0x80)
-				P3OUT &= 0xFD;               		//Disable Amplifier
-			else
-				P3OUT |= 0x02;          			//Enable Amplifier, Start PWM
+			playSteps++;
+			return 1;
+		}
+		playSteps++;
+	}
+	return 0;
+}
 
-			TA1CCR1 = waveform.data[k];  			//Waveform*1.625
-			for(j=0;j<waveform.data[k+1];++j)
-			{
-				timerdelay(Haptics_resonantModeTick);
-			}
+/*
+ * Haptics_Play - start playing a waveform from the TIMER1_A0 ISR.  The
+ * 		hardware mode is only changed when it differs and a running PWM is
+ * 		kept, so chained waveforms play without restarting the amplifier.
+ * 		Backends with isrMode = 0 keep the mode set by Haptics_ThreadMode.
+ * @param uint8_t* data - (amplitude, time) pairs
+ * @param uint8_t length - size of data in bytes
+ * @param uint8_t outputMode - ERM, LRA_AUTOON or LRA_AUTOOFF
+ * @param uint8_t gap - ticks of silence after the waveform
+ * @return uint8_t - 1 if the waveform is playing, 0 if it had nothing to play
+ */
+static uint8_t Haptics_Play(const uint8_t* data, uint8_t length, uint8_t outputMode, uint8_t gap)
+{
+	playStream = 0;
+	playSegments = outputMode & HAPTICS_SEGMENTS;
+	playEnvelope = (outputMode & HAPTICS_ENVELOPE) ? (const Envelope*) data : 0;
+	outputMode = Haptics_OutputMode(outputMode);
+
+	if(hardwareMode != outputMode)
+	{
+		if(backend->isrMode)
+			Haptics_HardwareMode(outputMode);	// Set hardware control pins
+		else if(hardwareMode < HAPTICS_MODES)
+			outputMode = hardwareMode;			// Set by Haptics_ThreadMode, e.g. a later sequence step
+	}
+	if(!(TA1CTL & MC_1))
+	{
+		Haptics_Supply();						// Measured without load
+		Haptics_PWMOn();						// Start PWM output
+	}
+
+	// One tick is HAPTICS_TICK_US, see Haptics_Init
+	playTickPeriods = tickPeriods;
+	playTickFraction = 0;
+	// LRA_AUTOOFF or PIEZO carrier, the frequency is taken when the waveform starts
+	playHalfPeriod = (uint16_t) (((uint32_t) ((outputMode == PIEZO) ? Haptics_piezoModeTick : Haptics_dumbModeTick)
+			* dumbTickScale) >> 8);
+	playCarrier = 0;
+	playPhase = 0;
+	playMode = outputMode;
+	Haptics_SetScale(outputMode);				// Taken when the waveform starts
+	playGap = gap;
+	playData = data;
+	playBytes = length;
+	playLoopCount = 0;
+	playReturn = 0;
+	playLevel = 0x80;						// Ramps at the start begin from zero drive
+	if(playEnvelope)
+	{
+		playEnvStage = 0;
+		playEnvRepeat = playEnvelope->repeat;
+	}
+
+	if(!Haptics_Advance())
+		return 0;
+
+#ifdef HAPTICS_STATS
+	if(statsPending)
+		Haptics_StatsBegin();					// First output of a queued waveform
+#endif
+	playPeriods = playTickPeriods;
+	playBusy = 1;
+	TA1CCTL0 &= ~CCIFG;
+	TA1CCTL0 |= CCIE;						// Step in the PWM period interrupt
+	return 1;
+}
+
+/*
+ * Haptics_OutputMode - the output mode a waveform plays in
+ * @param uint8_t outputMode - waveform outputMode, flags are ignored
+ * @return uint8_t - LRA_AUTOON, LRA_AUTOOFF, ERM or PIEZO
+ */
+static uint8_t Haptics_OutputMode(uint8_t outputMode)
+{
+	outputMode &= HAPTICS_MODE_MASK;
+	if(outputMode >= HAPTICS_MODES)
+		outputMode = LRA_AUTOON;				// Same as the Haptics_HardwareMode default
+	if(piezoOnly)
+		outputMode = PIEZO;						// Translated, see Haptics_Scale
+	return outputMode;
+}
+
+/*
+ * Haptics_ThreadMode - set the output mode from thread context on a backend
+ * 		whose mode change blocks (isrMode = 0, e.g. several I2C transfers).
+ * 		When the mode differs the playing and queued waveforms finish first.
+ * @param uint8_t outputMode - mode from Haptics_OutputMode
+ */
+static void Haptics_ThreadMode(uint8_t outputMode)
+{
+	if(backend->isrMode || (hardwareMode == outputMode))
+		return;
+	Haptics_WaitDone();
+	Haptics_HardwareMode(outputMode);
+}
+
+/*
+ * Haptics_Advance - output the next pair, or the gap after the last pair
+ * @return uint8_t - 1 if there is something to play, 0 at the end of the waveform
+ */
+static uint8_t Haptics_Advance(void)
+{
+	if(Haptics_NextPair())
+		return 1;
+
+	if(playGap)
+	{
+		playLevel = 0x80;						// Disable Amplifier, keep the PWM running
+		playDrive = 0;
+		Haptics_Output();
+		playRamp = 0;
+		playTicks = playGap;
+		playGap = 0;
+		return 1;
+	}
+	return 0;
+}
+
+/*
+ * Haptics_NextPair - output the next (amplitude, time) pair, pairs with a time
+ * 		of 0 are output and skipped.  In HAPTICS_SEGMENTS waveforms a time of 0
+ * 		is followed by a count N: (amplitude, 0, N) ramps from the current
+ * 		amplitude to amplitude over N ticks.  N = 0 is an escape, the first
+ * 		byte is the opcode (see Haptics_Escape).  Loops and calls are followed
+ * 		in place, each step reads at most one pair and a few escapes.
+ * @return uint8_t - 1 if a pair with time > 0 was loaded, 0 at the end of the waveform
+ */
+static uint8_t Haptics_NextPair(void)
+{
+	uint8_t amplitude;
+
+	if(playEnvelope)
+		return Haptics_NextSegment();
+
+	playRamp = 0;
+	for(;;)
+	{
+		if(playLoopCount && playBytes == playLoopEnd)
+		{
+			playLoopCount--;					// Next pass of the loop body
+			playData = playLoopStart;
+			playBytes = playLoopEnd + playLoopBytes;
 		}
-		break;
-	case LRA_AUTOOFF:		// LRA without Auto-Resonance
-		for(k=0; k<waveform.length; k=k+2)
+		if(playBytes < 2)
 		{
-			if(waveform.data[k] == 0x80)
-				P3OUT &= 0xFD;               		//Disable Amplifier
-			else
-				P3OUT |= 0x02;          			//Enable Amplifier, Start PWM
+			if(!playReturn)
+				return 0;
+			Haptics_Return();					// End of a shared segment
+			continue;
+		}
+
+		amplitude = playData[0];
+		playTicks = playData[1];
+		playData += 2;
+		playBytes -= 2;
 
-			for(j=0;j<waveform.data[k+1];++j)
+		if(!playTicks && playSegments && playBytes)
+		{
+			playTicks = *playData++;
+			playBytes--;
+			if(!playTicks)
 			{
-				TA1CCR1 = waveform.data[k];
-				timerdelay(Haptics_dumbModeTick);
-				TA1CCR1 = 255 - waveform.data[k];
-				timerdelay(Haptics_dumbModeTick);
+				Haptics_Escape(amplitude);
+				continue;
+			}
+			if(playTicks > 1)
+			{
+				Haptics_Ramp(Haptics_Scale(amplitude));
+				return 1;
 			}
 		}
-		break;
-	case ERM:		// ERM
-		for(k=0; k<waveform.length; k=k+2)
+
+		Haptics_SetLevel(Haptics_Scale(amplitude));
+
+		if(playTicks)
+			return 1;
+	}
+}
+
+/*
+ * Haptics_Escape - run a segment escape (opcode, 0, 0, ...) of the playing data.
+ * 		HAPTICS_LOOP: (0x80 + count, 0, 0, bytes) plays the next bytes count
+ * 		times, a loop ends the loop it is in.  HAPTICS_CALL: (segment, 0, 0)
+ * 		plays Waveforms_segments[segment] and continues after the call.
+ * 		Segments do not call segments, a call in a segment or to an unknown
+ * 		segment is skipped.
+ * @param uint8_t opcode - first byte of the escape
+ */
+static void Haptics_Escape(uint8_t opcode)
+{
+	if(opcode & HAPTICS_OP_LOOP)
+	{
+		if(!playBytes)
+			return;
+		playLoopBytes = *playData++;
+		playBytes--;
+		if(playLoopBytes > playBytes)
+			playLoopBytes = playBytes;
+		playLoopStart = playData;
+		playLoopEnd = playBytes - playLoopBytes;
+		playLoopCount = opcode & ~HAPTICS_OP_LOOP;
+		if(playLoopCount)
+			playLoopCount--;					// Passes after this one
+		else
+		{
+			playData += playLoopBytes;			// Count 0 skips the body
+			playBytes = playLoopEnd;
+		}
+		return;
+	}
+
+	if(playReturn || opcode >= SEGMENT_COUNT)
+		return;
+	playReturn = playData;
+	playReturnBytes = playBytes;
+	playCallerStart = playLoopStart;			// The segment may loop
+	playCallerBytes = playLoopBytes;
+	playCallerEnd = playLoopEnd;
+	playCallerCount = playLoopCount;
+	playLoopCount = 0;
+	playData = Waveforms_segments[opcode].data;
+	playBytes = Waveforms_segments[opcode].length;
+}
+
+/*
+ * Haptics_Return - continue the caller after the end of a shared segment
+ */
+static void Haptics_Return(void)
+{
+	playData = playReturn;
+	playBytes = playReturnBytes;
+	playReturn = 0;
+	playLoopStart = playCallerStart;
+	playLoopBytes = playCallerBytes;
+	playLoopEnd = playCallerEnd;
+	playLoopCount = playCallerCount;
+}
+
+/*
+ * Haptics_NextSegment - output the next stage of the playing envelope: attack,
+ * 		decay, sustain, release, then the gap before each repeat.  A stage of
+ * 		0 ticks sets its amplitude and is skipped.  The envelope is read at each
+ * 		stage, so a RAM envelope can be changed while it plays.
+ * @return uint8_t - 1 if a stage with ticks > 0 was loaded, 0 at the end of the envelope
+ */
+static uint8_t Haptics_NextSegment(void)
+{
+	const Envelope* envelope = playEnvelope;
+	uint8_t amplitude;
+
+	playRamp = 0;
+	for(;;)
+	{
+		switch(playEnvStage++)
+		{
+		case 0:		// Attack
+			amplitude = envelope->peak;
+			playTicks = envelope->attack;
+			break;
+		case 1:		// Decay
+			amplitude = envelope->level;
+			playTicks = envelope->decay;
+			break;
+		case 2:		// Sustain
+			amplitude = envelope->level;
+			playTicks = envelope->sustain;
+			break;
+		case 3:		// Release
+			amplitude = 0x80;
+			playTicks = envelope->release;
+			break;
+		default:	// Gap before the next repeat
+			if(playEnvRepeat <= 1)
+				return 0;
+			playEnvRepeat--;
+			playEnvStage = 0;
+			amplitude = 0x80;
+			playTicks = envelope->gap;
+			break;
+		}
+
+		amplitude = Haptics_Scale(amplitude);
+		if((playTicks > 1) && (amplitude != playLevel))
+		{
+			Haptics_Ramp(amplitude);
+			return 1;
+		}
+		Haptics_SetLevel(amplitude);
+
+		if(playTicks)
+			return 1;
+	}
+}
+
+/*
+ * Haptics_Ramp - start a linear ramp from the current amplitude over playTicks
+ * 		(> 1) ticks.  The first step is output now and the last tick outputs
+ * 		the exact target.
+ * @param uint8_t amplitude - amplitude at the end of the ramp
+ */
+static void Haptics_Ramp(uint8_t amplitude)
+{
+	playRampTarget = amplitude;
+	playRampStep = (((int16_t) amplitude - (int16_t) playLevel) * 128 / playTicks) * 2;
+	playRampLevel = ((uint16_t) playLevel << 8) + playRampStep;
+	playRamp = 1;
+	playDrive = 1;							// Enable Amplifier
+	playLevel = playRampLevel >> 8;
+	Haptics_Output();
+}
+
+/*
+ * Haptics_SetLevel - output a fixed amplitude, 0x80 disables the amplifier in LRA modes
+ * @param uint8_t amplitude - PWM duty cycle, 0x80 = no drive
+ */
+static void Haptics_SetLevel(uint8_t amplitude)
+{
+	playDrive = (playMode == ERM) || (amplitude != 0x80);	// Disable Amplifier in LRA modes
+	playLevel = amplitude;
+	Haptics_Output();
+}
+
+/*
+ * Haptics_SetScale - set the drive scale and limit of the playing waveform from
+ * 		the global and actuator intensity
+ * @param uint8_t outputMode - LRA_AUTOON, LRA_AUTOOFF or ERM
+ */
+static void Haptics_SetScale(uint8_t outputMode)
+{
+	uint16_t scale = ((uint16_t) globalIntensity * actuatorIntensity[outputMode]) >> 7;
+
+	scale = (scale * supplyScale) >> 7;
+	if(thermalState != HAPTICS_THERMAL_OK)
+		scale = (scale * HAPTICS_THERMAL_SCALE) >> 7;
+	playScale = (scale > 255) ? 255 : scale;
+	playMax = (modeMax[outputMode] < supplyMax) ? modeMax[outputMode] : supplyMax;
+}
+
+/*
+ * Haptics_Supply - measure VCC and set the supply compensation, see
+ * 		Haptics_SetSupplyCompensation.  Waits ~110us for the ADC, only called
+ * 		before the PWM starts.
+ */
+static void Haptics_Supply(void)
+{
+	supplyAge = 0;
+	supplyPending = 0;
+	supplyScale = HAPTICS_INTENSITY_FULL;
+	supplyMax = 0xFF;
+	if(!supplyCompensation)
+		return;
+
+	Haptics_SupplyScale(Supply_Measure());		// Cancels a measurement under load
+}
+
+/*
+ * Haptics_SupplyTick - measure VCC under load every HAPTICS_VCC_REFRESH ticks
+ * 		from the TIMER1_A0 ISR.  The measurement runs over the next few ticks,
+ * 		the ISR never waits for the reference or the ADC.
+ * @return uint8_t - 1 when a new measurement was applied
+ */
+static uint8_t Haptics_SupplyTick(void)
+{
+	uint16_t millivolts;
+
+	if(supplyPending)
+	{
+		millivolts = Supply_Poll();
+		if(!millivolts)
+			return 0;
+		supplyPending = 0;
+		if(supplyCompensation)
+			Haptics_SupplyScale(millivolts);
+		return 1;
+	}
+
+	if((++supplyAge >= HAPTICS_VCC_REFRESH) && supplyCompensation)
+	{
+		supplyAge = 0;
+		Supply_Start();
+		supplyPending = 1;
+	}
+	return 0;
+}
+
+/*
+ * Haptics_SupplyScale - set the supply compensation from a measurement
+ * @param uint16_t millivolts - VCC, 0 = not measured
+ */
+static void Haptics_SupplyScale(uint16_t millivolts)
+{
+	uint16_t scale;
+
+	Haptics_vccMillivolts = millivolts;
+	supplyScale = HAPTICS_INTENSITY_FULL;
+	supplyMax = 0xFF;
+	if(!millivolts)
+		return;
+
+	scale = (uint16_t) (((uint32_t) HAPTICS_VCC_NOMINAL * HAPTICS_INTENSITY_FULL) / Haptics_vccMillivolts);
+	if(Haptics_vccMillivolts < HAPTICS_VCC_LOW)
+	{
+		scale = HAPTICS_INTENSITY_FULL;			// Do not raise the current near brown out
+		supplyMax = HAPTICS_VCC_LOWMAX;
+	}
+	supplyScale = (scale > HAPTICS_VCC_SCALEMAX) ? HAPTICS_VCC_SCALEMAX : scale;
+}
+
+/*
+ * Haptics_ThermalTick - add one tick of the current drive to the energy model
+ * 		and decay it, from the TIMER1_A0 ISR
+ * @return uint8_t - 1 if the state changed
+ */
+static uint8_t Haptics_ThermalTick(void)
+{
+	uint8_t drive = (playLevel >= 0x80) ? playLevel - 0x80 : 0x80 - playLevel;
+	uint8_t state = thermalState;
+
+	thermalEnergy += (uint16_t) drive * drive;	// Braking heats the actuator too
+	thermalEnergy -= thermalEnergy >> HAPTICS_THERMAL_SHIFT;
+	Haptics_Thermal();
+	return state != thermalState;
+}
+
+/*
+ * Haptics_CoolStart - the PWM stopped, keep TA1 counting ACLK so the energy
+ * 		model cools in the TIMER1_A0 ISR every 2^HAPTICS_THERMAL_IDLESHIFT ticks
+ * 		until it is empty.  The ACLK interrupt leaves the low power mode alone.
+ */
+static void Haptics_CoolStart(void)
+{
+	if(!thermalEnergy)
+		return;
+	if(!thermalCoolCounts)
+		thermalCoolCounts = (uint16_t) ((((uint32_t) HAPTICS_TICK_US << HAPTICS_THERMAL_IDLESHIFT) * Timer_aclkHz
+				+ 500000) / 1000000);			// After Timer_Init measured ACLK
+	thermalCooling = 1;
+	TA1CCR0 = thermalCoolCounts;
+	TA1CTL = TASSEL_1 + MC_2 + TACLR;		// ACLK, continuous: (TA1CTL & MC_1) still means PWM on
+	TA1CCTL0 = CCIE;
+}
+
+/*
+ * Haptics_CoolStop - give TA1 back to the PWM, a partial cooling step is lost
+ */
+static void Haptics_CoolStop(void)
+{
+	TA1CCTL0 &= ~(CCIE | CCIFG);
+	if(!thermalCooling)
+		return;
+	thermalCooling = 0;
+	TA1CTL = TACLR;
+	TA1CCR0 = 0x00FF;						// PWM period, see main()
+}
+
+/*
+ * Haptics_Thermal - set the energy model state from the energy and the budget
+ */
+static void Haptics_Thermal(void)
+{
+	uint8_t state = HAPTICS_THERMAL_OK;
+
+	if(thermalLimit)
+	{
+		if(thermalEnergy >= thermalLimit + (thermalLimit >> 1))
+			state = HAPTICS_THERMAL_REFUSING;
+		else if(thermalEnergy >= thermalLimit)
+			state = HAPTICS_THERMAL_THROTTLED;
+	}
+	thermalState = state;
+}
+
+/*
+ * Haptics_Scale - clamp an amplitude to the output mode maximum, then apply
+ * 		the intensity of the playing waveform.  Clamping first keeps data
+ * 		written for a stronger mode (e.g. lra_alert in LRA_AUTOOFF) at the
+ * 		same level as its own table would be.  0x80 (no drive) is unchanged.
+ * 		In PIEZO mode brake amplitudes become no drive, the carrier would
+ * 		turn them into a vibration.
+ * @param uint8_t amplitude - PWM duty cycle from the waveform data
+ * @return uint8_t - PWM duty cycle to output
+ */
+static uint8_t Haptics_Scale(uint8_t amplitude)
+{
+	int16_t drive;
+
+	if(amplitude > playMax)
+		amplitude = playMax;
+	drive = (int16_t) amplitude - 0x80;
+
+	if((drive < 0) && (playMode == PIEZO))
+		return 0x80;
+
+	if(playScale != HAPTICS_INTENSITY_FULL)
+		drive = (drive * (int16_t) playScale) / HAPTICS_INTENSITY_FULL;
+	drive += 0x80;
+
+	if(drive > playMax)							// Scale above full intensity
+		return playMax;
+	if(drive < 0)
+		return 0;
+	return (uint8_t) drive;
+}
+
+/*
+ * Haptics_StreamSample - output the next streamed sample, swapping the buffer
+ * 		halves when the played half is empty.  The first half plays when it is
+ * 		full or after HAPTICS_STREAMFLUSH idle sample periods.  On an underrun
+ * 		the last sample is held.
+ * @return uint8_t - 1 while streaming, 0 after HAPTICS_STREAMTIMEOUT idle sample periods
+ */
+static uint8_t Haptics_StreamSample(void)
+{
+	if(streamPlayPos == streamPlayCount)
+	{
+		if(streamFillCount && (streamPrimed || (streamFillCount == HAPTICS_STREAMBUFFER)
+				|| (streamIdle >= HAPTICS_STREAMFLUSH)))
 		{
-			TA1CCR1 = waveform.data[k];  			//Waveform*1.625
-			for(j=0;j<waveform.data[k+1];++j)
+			streamPlayCount = streamFillCount;
+			streamPlayPos = 0;
+			streamFillCount = 0;
+			streamFill ^= 1;
+			streamPrimed = 1;
+			streamIdle = 0;
+		}
+		else
+		{
+			streamIdle++;
+			if(streamPrimed)
+				Haptics_streamUnderruns++;
+			if(streamIdle < HAPTICS_STREAMTIMEOUT)
+				return 1;
+
+			if(streamPrimed)
+				Haptics_streamUnderruns -= streamIdle;	// The end of the stream is not an underrun
+			Haptics_SetLevel(0x80);
+			playStream = 0;
+			return 0;
+		}
+	}
+
+	Haptics_SetLevel(Haptics_Scale(streamBuffer[streamFill ^ 1][streamPlayPos++]));
+	Haptics_streamSamples++;
+	return 1;
+}
+
+#ifdef HAPTICS_STATS
+/**
+ * Haptics_StatsClear - forget all playback statistics
+ */
+void Haptics_StatsClear(void)
+{
+	uint8_t i;
+
+	__bic_SR_register(GIE);
+	for(i = 0; i < HAPTICS_STATSSIZE; i++)
+		Haptics_stats[i].plays = 0;
+	__bis_SR_register(GIE);
+}
+
+/*
+ * Haptics_StatsBegin - the first pair of a queued waveform is output
+ */
+static void Haptics_StatsBegin(void)
+{
+	uint32_t latency;
+
+	if(!statsTickCounts)						// Timer_Init measures ACLK after Haptics_Init
+	{
+		statsTickCounts = (uint16_t) (((uint32_t) HAPTICS_TICK_US * Timer_aclkHz / 1000 * 256 + 500) / 1000);
+		statsPeriodCounts = (uint16_t) ((65536UL * Timer_aclkHz + Haptics_smclkHz / 2) / Haptics_smclkHz);
+		if(!statsPeriodCounts)
+			statsPeriodCounts = 1;
+	}
+	statsStart = Timer_Uptime();
+	latency = Haptics_StatsMicroseconds(statsStart - statsRequested);
+	statsLatency = (latency > 0xFFFF) ? 0xFFFF : (uint16_t) latency;
+	statsTicks = 0;
+	statsLost = 0;
+	statsLate = 0;
+	statsPending = 0;
+	statsActive = 1;
+}
+
+/*
+ * Haptics_StatsTick - count the PWM periods the player lost against the
+ * 		uptime, each is an ISR entry more than one period late.  One uptime
+ * 		count of rounding is allowed, shorter losses are not seen.  The
+ * 		uptime stands still while a touch scan borrows TA0 and catches up
+ * 		after, so a scan is not a loss.
+ */
+static void Haptics_StatsTick(void)
+{
+	uint32_t elapsed = Timer_Uptime() - statsStart;
+	int32_t lag;
+	uint16_t lost;
+
+	if(elapsed >= 0x800000)
+		return;									// Too long for 8.8 fixed point
+	lag = (int32_t) (elapsed << 8) - (int32_t) statsTicks * statsTickCounts - 256;
+	if(lag <= 0)
+		return;
+	lost = (uint16_t) (lag / statsPeriodCounts);
+	if(lost > statsLost)
+	{
+		statsLate += lost - statsLost;
+		statsLost = lost;
+	}
+}
+
+/*
+ * Haptics_StatsEnd - the recorded waveform ended or was cancelled, add it to
+ * 		the record of its effect ID
+ */
+static void Haptics_StatsEnd(void)
+{
+	PlayStats* stats = 0;
+	uint32_t nominal;
+	uint32_t actual;
+	uint16_t error;
+	uint8_t i;
+
+	statsPending = 0;
+	if(!statsActive)
+		return;
+	statsActive = 0;
+
+	for(i = 0; i < HAPTICS_STATSSIZE; i++)
+	{
+		if(Haptics_stats[i].plays && (Haptics_stats[i].id == statsId))
+		{
+			stats = &Haptics_stats[i];
+			break;
+		}
+		if(!stats && !Haptics_stats[i].plays)
+			stats = &Haptics_stats[i];			// First free record
+	}
+	if(!stats)
+		return;									// Table full
+	if(!stats->plays)
+	{
+		stats->id = statsId;
+		stats->latencyMax = 0;
+		stats->late = 0;
+	}
+
+	nominal = (uint32_t) statsTicks * HAPTICS_TICK_US;
+	actual = Haptics_StatsMicroseconds(Timer_Uptime() - statsStart);
+	if(stats->plays < 255)
+		stats->plays++;
+	stats->latency = statsLatency;
+	if(statsLatency > stats->latencyMax)
+		stats->latencyMax = statsLatency;
+	stats->duration = (uint16_t) ((statsTicks * (uint32_t) HAPTICS_TICK_US + 500) / 1000);
+	actual = (actual >= nominal) ? (actual - nominal) : (nominal - actual);
+	error = (actual > 0x7FFF) ? 0x7FFF : (uint16_t) actual;
+	stats->error = (actual >= nominal) ? (int16_t) error : -(int16_t) error;
+	stats->late += statsLate;
+}
+
+/*
+ * Haptics_StatsMicroseconds - convert uptime counts
+ * @param uint32_t counts - Timer_Uptime counts
+ * @return uint32_t - us, in 20us steps within a second
+ */
+static uint32_t Haptics_StatsMicroseconds(uint32_t counts)
+{
+	return (counts / Timer_aclkHz) * 1000000UL + ((counts % Timer_aclkHz) * 50000UL / Timer_aclkHz) * 20;
+}
+#endif
+
+/*
+ * Haptics_Output - output the current amplitude through the backend, inverted
+ * 		in the second half of the LRA_AUTOOFF carrier
+ */
+static void Haptics_Output(void)
+{
+	backend->output(playPhase ? (255 - playLevel) : playLevel, playDrive);
+}
+
+/*
+ * Haptics_Timer1_A0_ISR - waveform player, runs once per PWM period.  In
+ * 		LRA_AUTOOFF and PIEZO mode it also generates the carrier: the duty cycle swaps
+ * 		between amplitude and 255 - amplitude every carrier half period.
+ * 		Neither the half period nor the tick is a whole number of PWM periods,
+ * 		so both carry their remainder over and run without drift.
+ */
+#pragma vector=TIMER1_A0_VECTOR
+__interrupt void Haptics_Timer1_A0_ISR(void)
+{
+	uint8_t changed;
+
+	if(thermalCooling)
+	{
+		// Idle, TA1 counts ACLK: one cooling step of 2^HAPTICS_THERMAL_IDLESHIFT ticks
+		TA1CCR0 += thermalCoolCounts;
+		thermalEnergy -= (thermalEnergy >> (HAPTICS_THERMAL_SHIFT - HAPTICS_THERMAL_IDLESHIFT)) + 1;
+		Haptics_Thermal();
+		if(!thermalEnergy)
+			Haptics_CoolStop();
+		return;
+	}
+
+#ifdef HAPTICS_STATS
+	if(TA1R >= HAPTICS_STATS_LATE)
+		statsLate++;							// Held off by another interrupt, see Haptics_StatsTick
+#endif
+
+	if(playStream)
+	{
+		if(--playPeriods)
+			return;
+		playPeriods = playTickPeriods;
+
+		// The energy model counts ticks, the sample period is in PWM periods
+		thermalStreamPeriods += playTickPeriods;
+		while(thermalStreamPeriods >= tickPeriods)
+		{
+			thermalStreamPeriods -= tickPeriods;
+			if(Haptics_ThermalTick())
+				Haptics_SetScale(playMode);		// Throttle or restore from the next sample
+		}
+
+		if(!Haptics_StreamSample())
+		{
+			Haptics_StartNext();				// Stops the PWM when the queue is empty
+			if(!playBusy && playWaiting)
+				__bic_SR_register_on_exit(LPM0_bits);
+		}
+		return;
+	}
+
+	if(((playMode == LRA_AUTOOFF) || (playMode == PIEZO)) && backend->carrier)
+	{
+		playCarrier += 256;						// SMCLK cycles per PWM period
+		if(playCarrier >= playHalfPeriod)
+		{
+			playCarrier -= playHalfPeriod;
+			playPhase ^= 1;
+			Haptics_Output();
+		}
+	}
+
+	if(--playPeriods)
+		return;
+	playPeriods = playTickPeriods;
+	playTickFraction += tickRemainder;			// Tick length is tickPeriods + tickRemainder / 256
+	if(playTickFraction >= 256)
+	{
+		playTickFraction -= 256;
+		playPeriods++;
+	}
+
+#ifdef HAPTICS_STATS
+	statsTicks++;
+	if(statsActive)
+		Haptics_StatsTick();
+#endif
+
+	changed = Haptics_ThermalTick();
+	if(Haptics_SupplyTick() || changed)
+		Haptics_SetScale(playMode);				// Applies from the next pair
+
+	if(--playTicks)
+	{
+		if(playRamp)
+		{
+			playRampLevel += playRampStep;
+			playLevel = (playTicks == 1) ? playRampTarget : (playRampLevel >> 8);
+			Haptics_Output();
+		}
+		return;
+	}
+
+	if(!Haptics_Advance())
+	{
+		if(playStop)
+		{
+			// Next sequence step or queued waveform in the same PWM session
+			if(!Haptics_NextStep())
 			{
-				timerdelay(Haptics_resonantModeTick);
+#ifdef HAPTICS_STATS
+				Haptics_StatsEnd();
+#endif
+				Haptics_StartNext();			// Stops the PWM when the queue is empty
 			}
 		}
-		break;
+		else
+		{
+			TA1CCTL0 &= ~CCIE;
+			playBusy = 0;
+		}
+		if(!playBusy && playWaiting)
+			__bic_SR_register_on_exit(LPM0_bits);
 	}
 }
 
 
 /**
  * Haptics_HardwareMode - Set the hardware pins to the appropriate setting
+ * 		through the output backend
  * @param unsigned char outputMode - the waveform output type
- * @TODO - Modify this function to change actuator types (ERM, LRA, Piezo)
  */
 void Haptics_HardwareMode(uint8_t outputMode)
 {
+	hardwareMode = outputMode;
+	backend->mode(outputMode);
+}
+
+/**
+ * Haptics_SetBackend - select the output backend, e.g. Haptics_pwmBackend or
+ * 		Drv2605_backend.  Waits for the playing and queued waveforms and stops
+ * 		the old backend.
+ * @param Backend* newBackend - the backend, must stay valid
+ */
+void Haptics_SetBackend(const Backend* newBackend)
+{
+	uint8_t outputMode = hardwareMode;
+
+	Haptics_WaitDone();
+	Haptics_StopPWM();
+	backend = newBackend;
+	hardwareMode = 0xFF;
+	if(outputMode < HAPTICS_MODES)
+		Haptics_HardwareMode(outputMode);	// Set up the new backend here, not in the player
+}
+
+/**
+ * Haptics_GetBackend - get the output backend
+ * @return Backend* - the backend in use
+ */
+const Backend* Haptics_GetBackend(void)
+{
+	return backend;
+}
+
+/**
+ * Haptics_PlayLibraryEffect - play an effect from the driver's own library.
+ * 		Waits for the playing and queued waveforms, then the driver plays the
+ * 		effect by itself; the next waveform interrupts it.
+ * @param uint8_t outputMode - LRA_AUTOON, LRA_AUTOOFF or ERM, selects the library
+ * @param uint8_t effect - library effect number
+ * @return uint8_t - 1 if playing, 0 if the backend has no library or play back is disabled
+ */
+uint8_t Haptics_PlayLibraryEffect(uint8_t outputMode, uint8_t effect)
+{
+	if(!playEffect || !backend->effect)
+		return 0;
+
+	Haptics_WaitDone();
+	if(hardwareMode != outputMode)
+		Haptics_HardwareMode(outputMode);
+	return backend->effect(effect);
+}
+
+/*
+ * Pwm_Mode - DRV2603 backend, set the LRA/ERM pin and the load switch.  In
+ * 		PIEZO mode the PWM drives the piezo driver (PIEZO_ENABLE) instead.
+ * @param uint8_t outputMode - the waveform output type
+ */
+static void Pwm_Mode(uint8_t outputMode)
+{
+	if(outputMode == PIEZO)
+	{
+		P3OUT &= 0xFD;      // Disable the DRV2603
+		P3OUT &= 0xFE;      // Select ERM Mode on DRV2603
+		P2OUT &= 0xBF;      // Select ERM on Load Switch
+		pwmPiezo = 1;
+		return;
+	}
+	P1OUT &= ~PIEZO_ENABLE;	// Disable the piezo driver
+	pwmPiezo = 0;
+
 	switch(outputMode)
 	{
 	case LRA_AUTOON: 	// LRA with Auto-Resonance
@@ -137,15 +1581,21 @@ void Haptics_HardwareMode(uint8_t outputMode)
 void Haptics_StartPWM(void)
 {
 	if(playEffect)
-	{
-		P3OUT |= 0x02;                	// Enable Amplifier, Start PWM
-		BCSCTL2 = DIVS_0;               // SMCLK/(0:1,1:2,2:4,3:8)
-		TA1R=0;                        	// Reset PWM Count
-		TA1CCTL1 |= OUTMOD_7 + CCIE;   	// PWM Set/Reset Mode
-		TA1CTL = TASSEL_2 + MC_1;       // 2: TACLK = SMCLK
-		//TA1CCR1 = 0xFF/2;              	// Send 50%
-		//timerdelay(6400);              	// 1 ms Startup delay
-	}
+		Haptics_PWMOn();
+}
+
+/*
+ * Haptics_PWMOn - start the PWM, queued waveforms start even if play back was
+ * 		disabled after they were queued
+ */
+static void Haptics_PWMOn(void)
+{
+	Haptics_CoolStop();				// TA1 is the player tick again
+	BCSCTL2 = DIVS_0;               // SMCLK/(0:1,1:2,2:4,3:8)
+	TA1R=0;                        	// Reset PWM Count
+	TA1CTL = TASSEL_2 + MC_1;       // 2: TACLK = SMCLK, the player tick
+	backend->start();
+	//timerdelay(6400);              	// 1 ms Startup delay
 }
 
 /**
@@ -153,15 +1603,60 @@ void Haptics_StartPWM(void)
  */
 void Haptics_StopPWM(void)
 {
-	if(playEffect)
+	// Always allowed, the player may end after play back was disabled
+	backend->stop();
+	TA1CTL = 0x0004;                 // Stop PWM
+	TA1CCTL0 &= ~CCIE;               // Stop the player
+	supplyPending = 0;
+	Supply_Cancel();                 // Reference and ADC off
+	BCSCTL2 |= DIVS_0;               // SMCLK/(0:1,1:2,2:4,3:8)
+	Haptics_CoolStart();             // The actuator cools while the PWM is off
+}
+
+/*
+ * Pwm_Start - DRV2603 backend, enable the amplifier and the PWM output
+ */
+static void Pwm_Start(void)
+{
+	if(pwmPiezo)
+		P1OUT |= PIEZO_ENABLE;		// Enable the piezo driver, Start PWM
+	else
+		P3OUT |= 0x02;                	// Enable Amplifier, Start PWM
+	TA1CCTL1 |= OUTMOD_7;   		// PWM Set/Reset Mode
+	//TA1CCR1 = 0xFF/2;              	// Send 50%
+}
+
+/*
+ * Pwm_Stop - DRV2603 backend, disable the amplifier and hold the PWM output low
+ */
+static void Pwm_Stop(void)
+{
+	P3OUT &= 0xFD;                   // Disable Amplifier
+	P1OUT &= ~PIEZO_ENABLE;
+	TA1CCR1 = 0x00;
+	TA1CCTL1 &= ~(OUTMOD_7 | OUT);   // PWM output = LOW
+	P3OUT &= 0xFB;
+}
+
+/*
+ * Pwm_Output - DRV2603 backend, set the duty cycle and the EN pin
+ * @param uint8_t level - PWM duty cycle, 0x80 = no drive
+ * @param uint8_t drive - 0 disables the amplifier
+ */
+static void Pwm_Output(uint8_t level, uint8_t drive)
+{
+	if(pwmPiezo)
 	{
-		P3OUT &= 0xFD;                   // Disable Amplifier
-		TA1CCR1 = 0x00;
-		TA1CTL = 0x0004;                 // Stop PWM
-		TA1CCTL1 &= ~(OUTMOD_7 | OUT);   // PWM output = LOW
-		P3OUT &= 0xFB;
-		BCSCTL2 |= DIVS_0;               // SMCLK/(0:1,1:2,2:4,3:8)
+		if(drive)
+			P1OUT |= PIEZO_ENABLE;			//Enable the piezo driver
+		else
+			P1OUT &= ~PIEZO_ENABLE;
 	}
+	else if(drive)
+		P3OUT |= 0x02;          			//Enable Amplifier
+	else
+		P3OUT &= 0xFD;               		//Disable Amplifier
+	TA1CCR1 = level;
 }
 
 /**
@@ -6,24 +6,34 @@
  * Author: a0866685
  *
  * Description: This file contains the functions for sending haptics waveforms.
- * 		Edit this file when changing actuators.
- *
- * @TODO - Update this file when changing between actuators types
- * 			(ERM, LRA, Piezo)
+ * 		Each waveform selects its actuator type (LRA_AUTOON, LRA_AUTOOFF,
+ * 		ERM or PIEZO), Haptics_SetPiezo plays every waveform on a piezo.
  *
  ******************************************************************************/
 
 #ifndef HAPTICS_H_
 #define HAPTICS_H_
 
+#ifndef I2C_SIMULATION
 #include "msp430.h"
 #include "CTS/structure.h"
 #include "timer.h"
+#else
+#include <stdint.h>					// Host build of the I2C backend, see I2c.h
+#endif
 
 #define DELAY 		250
 #define DUMBTICK  	LRAFREQ_185	// Select the LRA resonant frequency for "dumb" (auto-resonance off) mode
+#define PIEZOTICK	PIEZOFREQ_300	// Select the piezo carrier frequency (see PIEZO)
+#define PIEZO_ENABLE	BIT4		// P1.4 = piezo driver enable
+
+// Waveform time unit.  A tick is HAPTICS_TICK_US at any SMCLK, Haptics_Init
+// derives the PWM periods per tick from the DCO calibration constants.
+#define HAPTICS_TICK_US			5405		// 5.405ms, one 185Hz LRA period
+#define HAPTICS_SMCLK_DEFAULT	8000000UL	// SMCLK when the DCO is not at a calibrated frequency
+#define HAPTICS_DUMBTICK_HZ		8000000UL	// SMCLK the LRAFREQ_* half periods are given for
 
-// LRA Resonant Frequencies (see DUMBTICK above)
+// LRA Resonant Frequencies (see DUMBTICK above), half periods in SMCLK cycles at 8MHz
 #define LRAFREQ_220	18182	// 220Hz
 #define LRAFREQ_215	18605	// 215Hz
 #define LRAFREQ_210	19048 	// 210Hz
@@ -37,42 +47,363 @@
 #define LRAFREQ_170	23529	// 170Hz
 #define LRAFREQ_165 24242	// 165Hz
 #define LRAFREQ_160 25000	// 160Hz
-#define LRAFREQ_155 15806	// 155Hz
+#define LRAFREQ_155 25806	// 155Hz
 #define LRAFREQ_150	26667	// 150Hz
 #define LRAFREQ_145	27586	// 145Hz
 
+// Piezo Carrier Frequencies (see PIEZOTICK above), half periods in SMCLK cycles at 8MHz
+#define PIEZOFREQ_500	8000	// 500Hz
+#define PIEZOFREQ_400	10000	// 400Hz
+#define PIEZOFREQ_300	13333	// 300Hz
+#define PIEZOFREQ_250	16000	// 250Hz
+
 // PWM output modes
 #define LRA_AUTOON 		0		// LRA Auto-resonance on
 #define LRA_AUTOOFF		1		// LRA Auto-resonance off
 #define ERM 			2		// ERM Output Mode
+#define PIEZO			3		// Piezo driver on the PWM, the player makes the carrier
+#define HAPTICS_MODES	4		// Number of output modes
+
+// Maximum drive per output mode, the player clamps scaled amplitudes to these
+#define LRA_AUTOON_MAX	 	0xF0 	// Set the maximum amplitude for auto-resonance ON mode
+#define LRA_AUTOOFF_MAX		0xD8 	//0xE6	// Set the maximum amplitude for auto-resonance OFF mode (2Vrms)
+#define ERM_MAX				0xFF	// Set the maximum amplitude for ERM mode
+#define PIEZO_MAX			0xFF	// Set the maximum amplitude for piezo mode
+
+// Intensity scale (see Haptics_SetIntensity), 128 = amplitudes as written in the waveform
+#define HAPTICS_INTENSITY_FULL	128
+
+// Supply compensation (see Haptics_SetSupplyCompensation).  Waveform amplitudes
+// are written for HAPTICS_VCC_NOMINAL, the drive is scaled by nominal / VCC.
+#define HAPTICS_VCC_NOMINAL		3000	// mV the waveforms are tuned for
+#define HAPTICS_VCC_SCALEMAX	192		// Largest compensation scale, 1.5x
+#define HAPTICS_VCC_LOW			2600	// mV below which the drive is limited
+#define HAPTICS_VCC_LOWMAX		0xC0	// Amplitude limit below HAPTICS_VCC_LOW, half drive
+#define HAPTICS_VCC_REFRESH		185		// Ticks between measurements while playing (1s)
+
+// Actuator energy model (see Haptics_SetThermalBudget).  Every tick adds the
+// squared drive (amplitude - 0x80)^2, the total decays by 1/2^SHIFT per tick.
+#define HAPTICS_THERMAL_SHIFT	10		// Decay time constant 2^SHIFT ticks (5.5s)
+#define HAPTICS_THERMAL_BUDGET	64		// Default sustained drive, half of full drive
+#define HAPTICS_THERMAL_SCALE	64		// Drive scale while throttled, 128 = 1
+#define HAPTICS_THERMAL_IDLESHIFT	3	// Idle cooling steps of 2^IDLESHIFT ticks (43ms)
+
+// Energy model states (see Haptics_GetThermalState), the value is the lowest
+// waveform priority that is still accepted
+#define HAPTICS_THERMAL_OK			0	// Below the budget
+#define HAPTICS_THERMAL_THROTTLED	1	// Over the budget: drive scaled down, low priority refused
+#define HAPTICS_THERMAL_REFUSING	2	// Over 1.5x the budget: only high priority accepted
+
+// Waveform format flags, added to the output mode
+#define HAPTICS_MODE_MASK	0x0F	// Output mode bits
+#define HAPTICS_SEGMENTS	0x10	// Data contains ramp segments (amplitude, 0, ticks), see Actuator_Waveforms.c
+#define HAPTICS_ENVELOPE	0x20	// Data points to an Envelope, see Actuator_Waveforms.c
+
+// Segment escapes in HAPTICS_SEGMENTS data (opcode, 0, 0, ...), see Actuator_Waveforms.c
+#define HAPTICS_CALL(segment)		(segment), 0x00, 0x00						// play Waveforms_segments[segment]
+#define HAPTICS_LOOP(count, bytes)	(0x80 + (count)), 0x00, 0x00, (bytes)		// play the next bytes count (1-127) times
+#define HAPTICS_OP_LOOP		0x80	// Opcodes below are calls, the low bits of a loop are the count
+
+// Waveform priorities (see Haptics_QueueWaveform)
+#define HAPTICS_PRIORITY_LOW	0	// Soft alerts and ramps, dropped first when the queue is full
+#define HAPTICS_PRIORITY_NORMAL	1	// Haptics_SendWaveform
+#define HAPTICS_PRIORITY_HIGH	2	// Button clicks, cancel a playing lower priority waveform
+#define HAPTICS_QUEUESIZE		4	// Waveforms waiting behind the playing one
+
+// Sample streaming (see Haptics_StreamStart)
+#define HAPTICS_STREAMBUFFER	32		// Bytes in each half of the double buffer
+#define HAPTICS_STREAMPERIODS	40		// Default sample period in PWM periods (781 samples/s at 8MHz)
+#define HAPTICS_STREAMFLUSH		4		// Idle samples before a partly filled first buffer plays
+#define HAPTICS_STREAMTIMEOUT	1000	// Idle samples that end the stream
+
+// Playback statistics, build with HAPTICS_STATS defined (see Haptics_stats)
+//#define HAPTICS_STATS
+#define HAPTICS_STATSSIZE		6		// Effect IDs recorded, later IDs are not recorded
+#define HAPTICS_STATS_LATE		128		// SMCLK cycles into the PWM period that make a timer step late
+#define HAPTICS_NOID			0xFF	// Stats ID of waveforms and sequences queued without an effect ID
 
 extern uint16_t Haptics_dumbModeTick;		// Sets the LRA Auto-resonance off frequency (use DUMBTICK above to set frequency)
-extern uint16_t Haptics_resonantModeTick;
+extern uint16_t Haptics_piezoModeTick;		// Sets the piezo carrier frequency (use PIEZOTICK above to set frequency)
+extern uint32_t Haptics_smclkHz;			// SMCLK while the PWM runs, set by Haptics_Init
+extern uint16_t Haptics_vccMillivolts;		// Last supply measurement, 0 = not measured
+extern volatile uint16_t Haptics_streamSamples;		// Samples output by the last stream
+extern volatile uint16_t Haptics_streamUnderruns;	// Sample periods with no data, the last sample was held
+extern volatile uint16_t Haptics_streamOverruns;	// Bytes dropped because both buffers were full
 
 // Waveform Structure Type Definition
 typedef struct Haptics_Waveform {
-	const unsigned char 	outputMode; 		// ERM, LRA_AUTOON, or LRA_AUTOOFF (see output modes above)
+	const unsigned char 	outputMode; 		// ERM, LRA_AUTOON, LRA_AUTOOFF or PIEZO (see output modes above)
 	const unsigned char		length;				// size of array in bytes
 	const unsigned char* 	data;				// pointer to waveform array data (waveform array is in (amplitude, time) pairs
 } Waveform;
 
+// Shared Segment Type Definition (see HAPTICS_CALL), data in the HAPTICS_SEGMENTS format
+typedef struct Haptics_Segment {
+	const unsigned char		length;				// size of array in bytes
+	const unsigned char*	data;				// (amplitude, time) pairs and ramps, no calls
+} Segment;
+
+// Envelope Type Definition (outputMode + HAPTICS_ENVELOPE, length sizeof(Envelope))
+// Attack, decay and release are linear ramps, amplitudes are scaled like waveform data
+typedef struct Haptics_Envelope {
+	unsigned char			attack;				// ticks from no drive (0x80) to peak
+	unsigned char			decay;				// ticks from peak to level
+	unsigned char			sustain;			// ticks at level
+	unsigned char			release;			// ticks from level to no drive
+	unsigned char			peak;				// amplitude at the end of the attack
+	unsigned char			level;				// sustain amplitude
+	unsigned char			repeat;				// times to play, 0 = once
+	unsigned char			gap;				// ticks of silence between repeats
+} Envelope;
+
+#ifdef HAPTICS_STATS
+// Playback Statistics Type Definition, one per effect ID.  Only queued
+// waveforms are recorded (not Haptics_OutputWaveform or streams).  Times are
+// measured on Timer_Uptime, one ACLK count (~170us) resolution, so a stalled
+// player shows as a duration error.
+typedef struct Haptics_PlayStats {
+	uint8_t					id;					// effect ID or HAPTICS_NOID, unused while plays = 0
+	uint8_t					plays;				// times started, stops at 255
+	uint16_t				latency;			// us from the request to the first output, last play
+	uint16_t				latencyMax;			// us, largest latency
+	uint16_t				duration;			// ms, nominal duration of the last play
+	int16_t					error;				// us, actual - nominal duration of the last play
+	uint16_t				late;				// timer steps late in their period (HAPTICS_STATS_LATE) or lost, all plays
+} PlayStats;
+
+extern PlayStats Haptics_stats[HAPTICS_STATSSIZE];
+#endif
+
+// Output Backend Type Definition (see Haptics_SetBackend).  The player times
+// the waveform in the TIMER1_A0 ISR and hands every amplitude to the backend,
+// levels are PWM duty cycles (0x80 = no drive) for all backends.  start, stop
+// and output run in the ISR and must not block.  A backend with isrMode = 0
+// has its mode set from thread context: a waveform in another output mode
+// waits for the playing ones, and a sequence plays in the mode of its first step.
+typedef struct Haptics_Backend {
+	void					(*mode)(uint8_t outputMode);	// select LRA_AUTOON, LRA_AUTOOFF, ERM or PIEZO
+	void					(*start)(void);					// driver on, the TA1 tick is already running
+	void					(*stop)(void);					// driver off
+	void					(*output)(uint8_t level, uint8_t drive);	// drive = 0: the driver may be disabled
+	uint8_t					(*effect)(uint8_t effect);		// play a driver library effect, 0 = no library
+	const unsigned char		carrier;						// the player makes the LRA_AUTOOFF and PIEZO carrier
+	const unsigned char		isrMode;						// mode may run in the TIMER1_A0 ISR
+} Backend;
+
+extern const Backend Haptics_pwmBackend;	// DRV2603 PWM input, EN and LRA/ERM pins
+
+// Sequence Step Type Definition (see Haptics_SendSequence)
+typedef struct Haptics_SequenceStep {
+	const Waveform*			waveform;			// waveform to play
+	const unsigned char		gap;				// ticks of silence after the waveform
+} SequenceStep;
+
 /**
- * Haptics_Init - initialize haptics variables and settings
+ * Haptics_Init - initialize haptics variables and settings.  Call after the
+ * 		DCO is set up, the tick length is derived from its frequency.
  */
 void Haptics_Init(void);
 
 /**
- * Haptics_SendWaveform - send haptic waveform
- * @param struct Waveform - the waveform output type, length in bytes, and data
+ * Haptics_SendWaveform - send haptic waveform with normal priority, see
+ * 		Haptics_QueueWaveform
+ * @param Waveform* waveform - the waveform output type, length in bytes, and data
+ */
+void Haptics_SendWaveform(const Waveform* waveform);
+
+/**
+ * Haptics_QueueWaveform - play a waveform in the TIMER1_A0 ISR and return.  A
+ * 		higher priority waveform cancels the playing one, otherwise it waits in
+ * 		the queue behind all waveforms of equal or higher priority.  When the
+ * 		queue is full the lowest priority waveform is dropped.  LRA_AUTOOFF
+ * 		waveforms use Haptics_dumbModeTick as it is when they start.  The data
+ * 		must stay valid until Haptics_IsBusy returns 0, the Waveform itself
+ * 		is copied.
+ * @param Waveform* waveform - the waveform output type, length in bytes, and data
+ * @param uint8_t priority - HAPTICS_PRIORITY_LOW, _NORMAL or _HIGH
+ * @return uint8_t - 1 if the waveform is playing or queued, 0 if it was dropped
+ */
+uint8_t Haptics_QueueWaveform(const Waveform* waveform, uint8_t priority);
+
+/**
+ * Haptics_SendEffect - send an effect by ID with normal priority
+ * @param uint8_t id - EFFECT_* ID (see Actuator_Waveforms.h) or a stored
+ * 		waveform ID, EFFECT_USER and above
+ * @return uint8_t - 1 if the effect is playing or queued, 0 if unknown or dropped
+ */
+uint8_t Haptics_SendEffect(uint8_t id);
+
+/**
+ * Haptics_QueueEffect - play or queue an effect by ID, see Haptics_QueueWaveform
+ * @param uint8_t id - EFFECT_* ID (see Actuator_Waveforms.h) or a stored
+ * 		waveform ID, EFFECT_USER and above
+ * @param uint8_t priority - HAPTICS_PRIORITY_LOW, _NORMAL or _HIGH
+ * @return uint8_t - 1 if the effect is playing or queued, 0 if unknown or dropped
+ */
+uint8_t Haptics_QueueEffect(uint8_t id, uint8_t priority);
+
+/**
+ * Haptics_SendSequence - play a list of waveforms, each followed by a gap, in
+ * 		one PWM session.  The amplifier is not restarted between steps and the
+ * 		hardware mode is only changed when a step uses a different output mode.
+ * 		The sequence is queued like a single waveform.
+ * @param SequenceStep* steps - waveforms and gaps, must stay valid while playing
+ * @param uint8_t count - number of steps
+ * @param uint8_t priority - HAPTICS_PRIORITY_LOW, _NORMAL or _HIGH
+ * @return uint8_t - 1 if the sequence is playing or queued, 0 if it was dropped
+ */
+uint8_t Haptics_SendSequence(const SequenceStep* steps, uint8_t count, uint8_t priority);
+
+/**
+ * Haptics_StreamStart - play PWM samples received by Haptics_StreamByte.  The
+ * 		TIMER1_A0 ISR outputs one sample per sample period from one half of a
+ * 		double buffer while Haptics_StreamByte fills the other.  Samples are
+ * 		scaled and clamped like waveform data, LRA_AUTOOFF samples are output
+ * 		as they are (the host makes the carrier).  Playback starts when the
+ * 		first buffer is full and the stream ends after HAPTICS_STREAMTIMEOUT
+ * 		sample periods without data, then queued waveforms play.  The playing
+ * 		waveform is cancelled and the stream can not be preempted.
+ * @param uint8_t outputMode - LRA_AUTOON, LRA_AUTOOFF or ERM
+ * @param uint8_t periods - sample period in PWM periods of 256 SMCLK cycles
+ * 		(32us at 8MHz), e.g. HAPTICS_STREAMPERIODS
+ * @return uint8_t - 1 if streaming, 0 if play back is disabled or the energy model refuses it
+ */
+uint8_t Haptics_StreamStart(uint8_t outputMode, uint8_t periods);
+
+/**
+ * Haptics_StreamByte - add a sample to the stream, called from the UART RX ISR
+ * 		(see Uart_SetReceiver)
+ * @param uint8_t sample - PWM duty cycle, 0x80 = no drive
+ */
+void Haptics_StreamByte(uint8_t sample);
+
+/**
+ * Haptics_SetBackend - select the output backend, e.g. Haptics_pwmBackend or
+ * 		Drv2605_backend.  Waits for the playing and queued waveforms, stops
+ * 		the old backend and sets the output mode on the new one.
+ * @param Backend* newBackend - the backend, must stay valid
+ */
+void Haptics_SetBackend(const Backend* newBackend);
+
+/**
+ * Haptics_GetBackend - get the output backend
+ * @return Backend* - the backend in use
+ */
+const Backend* Haptics_GetBackend(void);
+
+/**
+ * Haptics_PlayLibraryEffect - play an effect from the driver's own library.
+ * 		Waits for the playing and queued waveforms, then the driver plays the
+ * 		effect by itself; the next waveform interrupts it.
+ * @param uint8_t outputMode - LRA_AUTOON, LRA_AUTOOFF or ERM, selects the library
+ * @param uint8_t effect - library effect number
+ * @return uint8_t - 1 if playing, 0 if the backend has no library or play back is disabled
+ */
+uint8_t Haptics_PlayLibraryEffect(uint8_t outputMode, uint8_t effect);
+
+/**
+ * Haptics_OutputWaveform - control the PWM output pattern, returns when the
+ * 		waveform is done.  The PWM must already be running.
+ * @param Waveform* waveform - the waveform output type, length in bytes, and data
+ */
+void Haptics_OutputWaveform(const Waveform* waveform);
+
+/**
+ * Haptics_SetPiezo - play every waveform in PIEZO mode, for products with a
+ * 		piezo actuator.  LRA and ERM waveforms are translated: the amplitude
+ * 		sets the carrier amplitude and brake pairs (below 0x80) play as no
+ * 		drive, the piezo stops as soon as the drive does.  Takes effect when
+ * 		the next waveform starts.
+ * @param uint8_t enable - 1 = piezo, 0 = the output mode of each waveform
+ */
+void Haptics_SetPiezo(uint8_t enable);
+
+/**
+ * Haptics_SetIntensity - scale the drive of all waveforms.  Amplitudes
+ * 		are clamped to the output mode maximum (LRA_AUTOON_MAX, LRA_AUTOOFF_MAX,
+ * 		ERM_MAX, PIEZO_MAX), then the drive (amplitude - 0x80) is multiplied by
+ * 		intensity / 128 and by the actuator intensity and clamped again.  Takes
+ * 		effect when the next waveform starts.
+ * @param uint8_t intensity - HAPTICS_INTENSITY_FULL (128) = unscaled, 255 = ~2x
+ */
+void Haptics_SetIntensity(uint8_t intensity);
+
+/**
+ * Haptics_SetSupplyCompensation - keep the output voltage constant as the
+ * 		supply drops.  VCC is measured when the PWM starts and every
+ * 		HAPTICS_VCC_REFRESH ticks while it runs; the drive is scaled by
+ * 		HAPTICS_VCC_NOMINAL / VCC, at most HAPTICS_VCC_SCALEMAX.  Below
+ * 		HAPTICS_VCC_LOW the drive is not raised and amplitudes are limited to
+ * 		HAPTICS_VCC_LOWMAX so long alerts do not pull the supply into a brown
+ * 		out.  Enabled by default.
+ * @param uint8_t enable - 1 = compensate, 0 = waveform amplitudes as written
+ */
+void Haptics_SetSupplyCompensation(uint8_t enable);
+
+/**
+ * Haptics_SetThermalBudget - limit the energy delivered to the actuator.  The
+ * 		player integrates the squared drive with a decay of 2^HAPTICS_THERMAL_SHIFT
+ * 		ticks.  Over the energy of the budget drive played without a break,
+ * 		waveforms start scaled by HAPTICS_THERMAL_SCALE and low priority
+ * 		waveforms are refused; over 1.5x only high priority waveforms play.
+ * 		Haptics_OutputWaveform is only scaled, streams count as normal priority.
+ * 		While the PWM is stopped TA1 counts ACLK and the model keeps cooling;
+ * 		idle time with the PWM left running after Haptics_OutputWaveform does not
+ * 		count.
+ * @param uint8_t drive - sustained drive (amplitude - 0x80) 1-128, 0 = no limit
+ */
+void Haptics_SetThermalBudget(uint8_t drive);
+
+/**
+ * Haptics_GetThermalState - get the state of the energy model
+ * @return uint8_t - HAPTICS_THERMAL_OK, _THROTTLED or _REFUSING
+ */
+uint8_t Haptics_GetThermalState(void);
+
+/**
+ * Haptics_GetThermalLoad - get the energy of the model relative to the budget
+ * @return uint8_t - percent of the budget, 255 = 255% or more, 0 with no limit
+ */
+uint8_t Haptics_GetThermalLoad(void);
+
+/**
+ * Haptics_GetIntensity - get the global intensity
+ * @return uint8_t - intensity, HAPTICS_INTENSITY_FULL = unscaled
+ */
+uint8_t Haptics_GetIntensity(void);
+
+/**
+ * Haptics_SetActuatorIntensity - scale the drive of one output mode, applied
+ * 		on top of the global intensity (see Haptics_SetIntensity)
+ * @param uint8_t outputMode - LRA_AUTOON, LRA_AUTOOFF or ERM
+ * @param uint8_t intensity - HAPTICS_INTENSITY_FULL (128) = unscaled, 255 = ~2x
+ */
+void Haptics_SetActuatorIntensity(uint8_t outputMode, uint8_t intensity);
+
+/**
+ * Haptics_GetActuatorIntensity - get the intensity of one output mode
+ * @param uint8_t outputMode - LRA_AUTOON, LRA_AUTOOFF or ERM
+ * @return uint8_t - intensity, HAPTICS_INTENSITY_FULL = unscaled
+ */
+uint8_t Haptics_GetActuatorIntensity(uint8_t outputMode);
+
+#ifdef HAPTICS_STATS
+/**
+ * Haptics_StatsClear - forget all playback statistics
+ */
+void Haptics_StatsClear(void);
+#endif
+
+/**
+ * Haptics_IsBusy - check if a waveform is playing or queued
+ * @return uint8_t - 1 while a waveform is playing, 0 when done
  */
-void Haptics_SendWaveform(const Waveform waveform);
+uint8_t Haptics_IsBusy(void);
 
 /**
- * Haptics_OutputWaveform - control the PWM output pattern
- * @param struct Waveform - the waveform output type, length in bytes, and data
- * @TODO - Modify this function to change actuator types (ERM, LRA, Piezo)
+ * Haptics_WaitDone - sleep in LPM0 until the playing and queued waveforms are done
  */
-void Haptics_OutputWaveform(const Waveform waveform);
+void Haptics_WaitDone(void);
 
 /**
  * Haptics_StartPWM - Initialize PWM clocks and enable the haptics driver
@@ -86,8 +417,8 @@ void Haptics_StopPWM(void);
 
 /**
  * Haptics_HardwareMode - Set the hardware pins to the appropriate setting
+ * 		through the output backend
  * @param unsigned char outputMode - the waveform output type
- * @TODO - Modify this function to change actuator types (ERM, LRA, Piezo)
  */
 void Haptics_HardwareMode(uint8_t outputMode);
 
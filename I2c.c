@@ -0,0 +1,355 @@
+/******************************************************************************
+ * I2c.c
+ *
+ * Created on: Oct 19, 2026
+ * Board: DRV2603EVM-CT RevD
+ *
+ * Desc: This file contains the USCI_B0 I2C master functions (P1.6 = SCL,
+ * 		P1.7 = SDA) used to talk to an integrated haptic driver.  Register
+ * 		reads and writes poll the USCI flags and block for a transfer (~0.3ms
+ * 		at I2C_BITRATE).  I2c_Post queues a register write for the USCIAB0TX
+ * 		interrupt and returns at once, so it can be used from an ISR.  The
+ * 		UART transmits polled and only uses the USCIAB0RX vector.
+ *
+ ******************************************************************************/
+
+#include "I2c.h"
+
+#ifndef I2C_SIMULATION
+
+// posted register write states, see I2c_PostStep
+#define I2C_POST_REG	0			// START is out, send the register address
+#define I2C_POST_VALUE	1			// send the value
+#define I2C_POST_END	2			// the value is being shifted out
+
+typedef struct I2c_PostEntry {
+	uint8_t		address;
+	uint8_t		reg;
+	uint8_t		value;
+} PostEntry;
+
+// private variables, posts[postHead] is being sent while postCount > 0
+static PostEntry posts[I2C_POSTSIZE];
+static volatile uint8_t postHead;
+static volatile uint8_t postCount;
+static uint8_t postState;
+
+// private functions
+static uint8_t I2c_Wait(uint8_t flag);
+static uint8_t I2c_Stop(void);
+static uint8_t I2c_Abort(void);
+static void I2c_Drain(void);
+static void I2c_PostStart(void);
+static void I2c_PostStep(void);
+static void I2c_PostAbort(void);
+
+/**
+ * I2c_Init - set up USCI_B0 as I2C master on P1.6/P1.7
+ * @param uint32_t smclkHz - SMCLK frequency, the bit rate is I2C_BITRATE
+ */
+void I2c_Init(uint32_t smclkHz)
+{
+	uint16_t divider = (uint16_t) ((smclkHz + I2C_BITRATE - 1) / I2C_BITRATE);
+
+	UCB0CTL1 |= UCSWRST;					// Hold the USCI in reset
+	P1SEL |= BIT6 + BIT7;					// P1.6 = SCL, P1.7 = SDA
+	P1SEL2 |= BIT6 + BIT7;
+	UCB0CTL0 = UCMST + UCMODE_3 + UCSYNC;	// I2C master, synchronous
+	UCB0CTL1 = UCSSEL_2 + UCSWRST;			// SMCLK
+	UCB0BR0 = (uint8_t) divider;
+	UCB0BR1 = (uint8_t) (divider >> 8);
+	UCB0CTL1 &= ~UCSWRST;
+	IE2 &= ~(UCB0TXIE + UCB0RXIE);			// I2c_Post enables UCB0TXIE while it sends
+	postCount = 0;
+}
+
+/**
+ * I2c_WriteRegister - write one register of a target
+ * @param uint8_t address - 7 bit target address
+ * @param uint8_t reg - register address
+ * @param uint8_t value - value to write
+ * @return uint8_t - 1 if the target acknowledged, 0 on NACK or timeout
+ */
+uint8_t I2c_WriteRegister(uint8_t address, uint8_t reg, uint8_t value)
+{
+	I2c_Drain();
+	UCB0I2CSA = address;
+	UCB0CTL1 |= UCTR + UCTXSTT;				// Start, transmit
+	if(!I2c_Wait(UCB0TXIFG))
+		return I2c_Abort();
+	UCB0TXBUF = reg;
+	if(!I2c_Wait(UCB0TXIFG))
+		return I2c_Abort();
+	UCB0TXBUF = value;
+	if(!I2c_Wait(UCB0TXIFG))
+		return I2c_Abort();
+	return I2c_Stop();
+}
+
+/**
+ * I2c_ReadRegister - read one register of a target
+ * @param uint8_t address - 7 bit target address
+ * @param uint8_t reg - register address
+ * @param uint8_t* value - the register value, unchanged on failure
+ * @return uint8_t - 1 if the target acknowledged, 0 on NACK or timeout
+ */
+uint8_t I2c_ReadRegister(uint8_t address, uint8_t reg, uint8_t* value)
+{
+	uint16_t timeout = I2C_TIMEOUT;
+
+	I2c_Drain();
+	UCB0I2CSA = address;
+	UCB0CTL1 |= UCTR + UCTXSTT;				// Start, transmit the register address
+	if(!I2c_Wait(UCB0TXIFG))
+		return I2c_Abort();
+	UCB0TXBUF = reg;
+	if(!I2c_Wait(UCB0TXIFG))
+		return I2c_Abort();
+
+	UCB0CTL1 &= ~UCTR;
+	UCB0CTL1 |= UCTXSTT;					// Repeated start, receive
+	while((UCB0CTL1 & UCTXSTT) && --timeout);
+	if(!timeout || (UCB0STAT & UCNACKIFG))
+		return I2c_Abort();
+	UCB0CTL1 |= UCTXSTP;					// Stop after the single byte
+	if(!I2c_Wait(UCB0RXIFG))
+		return I2c_Abort();
+	*value = UCB0RXBUF;
+	return I2c_Stop();
+}
+
+/**
+ * I2c_Post - queue a register write and return, the USCIAB0TX interrupt sends
+ * 		it.  A write to the same register as the last queued one replaces its
+ * 		value.  Safe to call from an ISR.  A NACK drops the queued writes.
+ * @param uint8_t address - 7 bit target address
+ * @param uint8_t reg - register address
+ * @param uint8_t value - value to write
+ * @return uint8_t - 1 if queued, 0 if the queue is full
+ */
+uint8_t I2c_Post(uint8_t address, uint8_t reg, uint8_t value)
+{
+	uint16_t contextSaveSR = __get_SR_register();
+	PostEntry* entry;
+	uint8_t queued = 1;
+
+	__disable_interrupt();
+	if(postCount && (UCB0STAT & UCNACKIFG))
+		I2c_PostAbort();					// The target is gone, the transfer is stuck
+
+	entry = &posts[(postHead + postCount + I2C_POSTSIZE - 1) % I2C_POSTSIZE];	// Newest
+	if((postCount > 1) && (entry->address == address) && (entry->reg == reg))
+		entry->value = value;				// Not started yet, send the newest value only
+	else if(postCount == I2C_POSTSIZE)
+		queued = 0;
+	else
+	{
+		entry = &posts[(postHead + postCount) % I2C_POSTSIZE];
+		entry->address = address;
+		entry->reg = reg;
+		entry->value = value;
+		if(!postCount++)
+			I2c_PostStart();
+	}
+
+	__bis_SR_register(contextSaveSR & GIE);
+	return queued;
+}
+
+/*
+ * I2c_Transmit_ISR - send the posted register writes, one interrupt per byte.
+ * 		In I2C mode the USCI_B0 RX flag shares this vector, reads are polled
+ * 		with UCB0RXIE off.
+ */
+#pragma vector=USCIAB0TX_VECTOR
+__interrupt void I2c_Transmit_ISR(void)
+{
+	if(UCB0STAT & UCNACKIFG)
+		I2c_PostAbort();
+	else if(IFG2 & UCB0TXIFG)
+		I2c_PostStep();
+}
+
+/*
+ * I2c_PostStart - address the target of posts[postHead], a repeated start
+ * 		when the previous write has not stopped.  Called with interrupts disabled.
+ */
+static void I2c_PostStart(void)
+{
+	UCB0I2CSA = posts[postHead].address;
+	UCB0CTL1 |= UCTR + UCTXSTT;
+	postState = I2C_POST_REG;
+	IE2 |= UCB0TXIE;
+}
+
+/*
+ * I2c_PostStep - load the next byte of the posted write, or start the next
+ * 		write or stop when the value is out.  Called with interrupts disabled
+ * 		when UCB0TXIFG is set.
+ */
+static void I2c_PostStep(void)
+{
+	switch(postState)
+	{
+	case I2C_POST_REG:
+		UCB0TXBUF = posts[postHead].reg;
+		postState = I2C_POST_VALUE;
+		break;
+	case I2C_POST_VALUE:
+		UCB0TXBUF = posts[postHead].value;
+		postState = I2C_POST_END;
+		break;
+	default:
+		postHead = (postHead + 1) % I2C_POSTSIZE;
+		if(--postCount)
+			I2c_PostStart();				// Repeated start after the value
+		else
+		{
+			UCB0CTL1 |= UCTXSTP;			// Stop after the value
+			IE2 &= ~UCB0TXIE;
+		}
+		break;
+	}
+}
+
+/*
+ * I2c_PostAbort - stop a failed posted write and drop the queue.  Called with
+ * 		interrupts disabled.
+ */
+static void I2c_PostAbort(void)
+{
+	IE2 &= ~UCB0TXIE;
+	postCount = 0;
+	I2c_Stop();
+}
+
+/*
+ * I2c_Drain - finish the posted writes before a polled transfer.  Sends them
+ * 		by polling, the caller may have interrupts disabled.
+ */
+static void I2c_Drain(void)
+{
+	uint16_t contextSaveSR = __get_SR_register();
+	uint16_t timeout = I2C_TIMEOUT;
+
+	__disable_interrupt();
+	while(postCount)
+	{
+		if(IFG2 & UCB0TXIFG)
+		{
+			I2c_PostStep();
+			timeout = I2C_TIMEOUT;
+		}
+		else if((UCB0STAT & UCNACKIFG) || !--timeout)
+			I2c_PostAbort();
+	}
+	timeout = I2C_TIMEOUT;
+	while((UCB0CTL1 & UCTXSTP) && --timeout);	// The last stop is out
+	__bis_SR_register(contextSaveSR & GIE);
+}
+
+/*
+ * I2c_Wait - poll for a USCI_B0 flag in IFG2
+ * @param uint8_t flag - UCB0TXIFG or UCB0RXIFG
+ * @return uint8_t - 1 when the flag is set, 0 on NACK or timeout
+ */
+static uint8_t I2c_Wait(uint8_t flag)
+{
+	uint16_t timeout = I2C_TIMEOUT;
+
+	while(!(IFG2 & flag))
+	{
+		if((UCB0STAT & UCNACKIFG) || !--timeout)
+			return 0;
+	}
+	return 1;
+}
+
+/*
+ * I2c_Stop - end the transfer and clear a NACK
+ * @return uint8_t - 1 if the transfer was acknowledged
+ */
+static uint8_t I2c_Stop(void)
+{
+	uint16_t timeout = I2C_TIMEOUT;
+	uint8_t acked = !(UCB0STAT & UCNACKIFG);
+
+	if(!(UCB0CTL1 & UCTXSTP))
+		UCB0CTL1 |= UCTXSTP;
+	while((UCB0CTL1 & UCTXSTP) && --timeout);
+	UCB0STAT &= ~UCNACKIFG;
+	IFG2 &= ~(UCB0TXIFG + UCB0RXIFG);
+	return acked && timeout;
+}
+
+/*
+ * I2c_Abort - end a failed transfer
+ * @return uint8_t - always 0
+ */
+static uint8_t I2c_Abort(void)
+{
+	I2c_Stop();
+	return 0;
+}
+
+#else
+
+// simulated target
+uint8_t I2c_simAddress;
+uint8_t I2c_simRegisters[I2C_SIMREGISTERS];
+uint16_t I2c_simWrites;
+
+/**
+ * I2c_Init - simulated, nothing to set up
+ * @param uint32_t smclkHz - unused
+ */
+void I2c_Init(uint32_t smclkHz)
+{
+	(void) smclkHz;
+}
+
+/**
+ * I2c_WriteRegister - write one register of the simulated target
+ * @param uint8_t address - 7 bit target address, NACK unless I2c_simAddress
+ * @param uint8_t reg - register address
+ * @param uint8_t value - value to write
+ * @return uint8_t - 1 if the target acknowledged, 0 on NACK
+ */
+uint8_t I2c_WriteRegister(uint8_t address, uint8_t reg, uint8_t value)
+{
+	if(address != I2c_simAddress)
+		return 0;
+	I2c_simRegisters[reg] = value;
+	I2c_simWrites++;
+	return 1;
+}
+
+/**
+ * I2c_ReadRegister - read one register of the simulated target
+ * @param uint8_t address - 7 bit target address, NACK unless I2c_simAddress
+ * @param uint8_t reg - register address
+ * @param uint8_t* value - the register value, unchanged on failure
+ * @return uint8_t - 1 if the target acknowledged, 0 on NACK
+ */
+uint8_t I2c_ReadRegister(uint8_t address, uint8_t reg, uint8_t* value)
+{
+	if(address != I2c_simAddress)
+		return 0;
+	*value = I2c_simRegisters[reg];
+	return 1;
+}
+
+/**
+ * I2c_Post - write one register of the simulated target at once
+ * @param uint8_t address - 7 bit target address, dropped unless I2c_simAddress
+ * @param uint8_t reg - register address
+ * @param uint8_t value - value to write
+ * @return uint8_t - always 1, the write is queued on the hardware too
+ */
+uint8_t I2c_Post(uint8_t address, uint8_t reg, uint8_t value)
+{
+	I2c_WriteRegister(address, reg, value);
+	return 1;
+}
+
+#endif /* I2C_SIMULATION */
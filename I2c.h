@@ -0,0 +1,77 @@
+/******************************************************************************
+ * I2c.h
+ *
+ * Created on: Oct 19, 2026
+ * Board: DRV2603EVM-CT RevD
+ *
+ * Desc: This file contains the USCI_B0 I2C master functions (P1.6 = SCL,
+ * 		P1.7 = SDA) used to talk to an integrated haptic driver.  Register
+ * 		reads and writes poll the USCI flags and block for a transfer (~0.3ms
+ * 		at I2C_BITRATE).  I2c_Post queues a register write for the USCIAB0TX
+ * 		interrupt and returns at once, so it can be used from an ISR.  The
+ * 		UART transmits polled and only uses the USCIAB0RX vector.
+ *
+ * 		Build with I2C_SIMULATION defined to replace the USCI with a
+ * 		simulated register target, so the driver code above it can run on a
+ * 		host build without the MCU headers (see test/Makefile).
+ *
+ ******************************************************************************/
+
+#ifndef I2C_H_
+#define I2C_H_
+
+#ifndef I2C_SIMULATION
+#include "msp430.h"
+#endif
+#include <stdint.h>
+
+#define I2C_BITRATE		100000UL	// SCL frequency
+#define I2C_TIMEOUT		2000		// Flag polls before a transfer is abandoned
+#define I2C_POSTSIZE	8			// Register writes I2c_Post can queue, a power of 2
+
+#ifdef I2C_SIMULATION
+// Simulated target: one device with 256 byte registers, register 0 to
+// I2C_SIMREGISTERS - 1.  A host test sets the address and reset values,
+// then checks the registers and write count after driving the code under test.
+#define I2C_SIMREGISTERS	256
+extern uint8_t I2c_simAddress;						// 7 bit address of the simulated target
+extern uint8_t I2c_simRegisters[I2C_SIMREGISTERS];	// target register file
+extern uint16_t I2c_simWrites;						// register writes acknowledged
+#endif
+
+/**
+ * I2c_Init - set up USCI_B0 as I2C master on P1.6/P1.7
+ * @param uint32_t smclkHz - SMCLK frequency, the bit rate is I2C_BITRATE
+ */
+void I2c_Init(uint32_t smclkHz);
+
+/**
+ * I2c_WriteRegister - write one register of a target
+ * @param uint8_t address - 7 bit target address
+ * @param uint8_t reg - register address
+ * @param uint8_t value - value to write
+ * @return uint8_t - 1 if the target acknowledged, 0 on NACK or timeout
+ */
+uint8_t I2c_WriteRegister(uint8_t address, uint8_t reg, uint8_t value);
+
+/**
+ * I2c_ReadRegister - read one register of a target
+ * @param uint8_t address - 7 bit target address
+ * @param uint8_t reg - register address
+ * @param uint8_t* value - the register value, unchanged on failure
+ * @return uint8_t - 1 if the target acknowledged, 0 on NACK or timeout
+ */
+uint8_t I2c_ReadRegister(uint8_t address, uint8_t reg, uint8_t* value);
+
+/**
+ * I2c_Post - queue a register write and return, the USCIAB0TX interrupt sends
+ * 		it.  A write to the same register as the last queued one replaces its
+ * 		value.  Safe to call from an ISR.  A NACK drops the queued writes.
+ * @param uint8_t address - 7 bit target address
+ * @param uint8_t reg - register address
+ * @param uint8_t value - value to write
+ * @return uint8_t - 1 if queued, 0 if the queue is full
+ */
+uint8_t I2c_Post(uint8_t address, uint8_t reg, uint8_t value);
+
+#endif /* I2C_H_ */
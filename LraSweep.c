@@ -0,0 +1,124 @@
+/******************************************************************************
+ * LraSweep.c
+ *
+ * Created on: Oct 19, 2026
+ * Board: DRV2603EVM-CT RevD
+ *
+ * Desc: This file contains the LRA resonance sweep.  A burst is played in
+ * 		LRA_AUTOOFF mode at each frequency from LRASWEEP_LOW_HZ to
+ * 		LRASWEEP_HIGH_HZ and the sweep pauses for a rating over the UART, a
+ * 		user's score or an accelerometer reading from the host (see
+ * 		tools/lra_sweep.py).  The best rated Haptics_dumbModeTick is saved in
+ * 		INFOB and loaded at start up.
+ *
+ ******************************************************************************/
+
+#include "LraSweep.h"
+#include "Flash.h"
+#include "Uart.h"
+
+// Saved sweep result in INFOB
+typedef struct LraSweep_Settings {
+	uint16_t	signature;			// LRASWEEP_SIGNATURE
+	uint16_t	dumbModeTick;		// best Haptics_dumbModeTick
+	uint16_t	check;				// ~dumbModeTick
+} LraSettings;
+
+#define LRASWEEP_SETTINGS	((const LraSettings*) FLASH_INFOB)
+
+// Burst played at each step: ramp up over 3 ticks, hold ~200ms, release
+static const unsigned char lraSweepBurst_data[] = {
+		LRA_AUTOOFF_MAX, 0x00, 0x03,
+		LRA_AUTOOFF_MAX, 0x25,
+		0x80, 0x01};
+static const Waveform lraSweepBurst = {LRA_AUTOOFF+HAPTICS_SEGMENTS,sizeof(lraSweepBurst_data),lraSweepBurst_data};
+
+// private functions
+static void LraSweep_Save(uint16_t dumbModeTick);
+
+/**
+ * LraSweep_Run - sweep the LRA_AUTOOFF carrier frequency and read a rating
+ * 		after each burst, the best frequency is saved
+ * @return uint16_t - best frequency in Hz, 0 if stopped or nothing was rated
+ */
+uint16_t LraSweep_Run(void)
+{
+	uint16_t oldTick = Haptics_dumbModeTick;
+	uint16_t hz;
+	uint16_t rating;
+	uint16_t bestHz = 0;
+	uint16_t bestRating = 0;
+	char end = 0;
+
+	printf("\r\nLRA sweep, rate each step (larger = stronger)\r\n");
+	for(hz = LRASWEEP_LOW_HZ; hz <= LRASWEEP_HIGH_HZ; hz += LRASWEEP_STEP_HZ)
+	{
+		Haptics_dumbModeTick = LRASWEEP_HALFPERIOD(hz);
+		Haptics_SendWaveform(&lraSweepBurst);
+		Haptics_WaitDone();		// frequency is read when the waveform starts
+
+		Uart_PrintNumber(hz);
+		printf(" Hz: ");
+		rating = Uart_ReadNumber(&end);
+		printf("\r\n");
+		if(rating == UART_NONUMBER)
+		{
+			Haptics_dumbModeTick = oldTick;
+			printf("Stopped\r\n");
+			return 0;
+		}
+		if(rating > bestRating)
+		{
+			bestRating = rating;
+			bestHz = hz;
+		}
+	}
+
+	if(!bestHz)
+	{
+		Haptics_dumbModeTick = oldTick;
+		printf("Nothing rated\r\n");
+		return 0;
+	}
+
+	Haptics_dumbModeTick = LRASWEEP_HALFPERIOD(bestHz);
+	LraSweep_Save(Haptics_dumbModeTick);
+	printf("Best ");
+	Uart_PrintNumber(bestHz);
+	printf(" Hz, saved\r\n");
+	return bestHz;
+}
+
+/**
+ * LraSweep_Load - set Haptics_dumbModeTick from the saved sweep result
+ * @return uint8_t - 1 if a saved frequency was loaded, 0 if none is saved
+ */
+uint8_t LraSweep_Load(void)
+{
+	const LraSettings* settings = LRASWEEP_SETTINGS;
+
+	if((settings->signature != LRASWEEP_SIGNATURE) || (settings->check != (uint16_t) ~settings->dumbModeTick))
+		return 0;
+	if((settings->dumbModeTick < LRASWEEP_HALFPERIOD(LRASWEEP_HIGH_HZ))
+			|| (settings->dumbModeTick > LRASWEEP_HALFPERIOD(LRASWEEP_LOW_HZ)))
+		return 0;
+
+	Haptics_dumbModeTick = settings->dumbModeTick;
+	return 1;
+}
+
+/*
+ * LraSweep_Save - store the sweep result in INFOB, the player must be idle
+ * @param uint16_t dumbModeTick - Haptics_dumbModeTick to load at start up
+ */
+static void LraSweep_Save(uint16_t dumbModeTick)
+{
+	LraSettings settings;
+
+	settings.signature = LRASWEEP_SIGNATURE;
+	settings.dumbModeTick = dumbModeTick;
+	settings.check = ~dumbModeTick;
+
+	Flash_EraseSegment(FLASH_INFOB);
+	Flash_Write(FLASH_INFOB, (const uint8_t*) &settings, sizeof(settings));
+}
@@ -0,0 +1,44 @@
+/******************************************************************************
+ * LraSweep.h
+ *
+ * Created on: Oct 19, 2026
+ * Board: DRV2603EVM-CT RevD
+ *
+ * Desc: This file contains the LRA resonance sweep.  A burst is played in
+ * 		LRA_AUTOOFF mode at each frequency from LRASWEEP_LOW_HZ to
+ * 		LRASWEEP_HIGH_HZ and the sweep pauses for a rating over the UART, a
+ * 		user's score or an accelerometer reading from the host (see
+ * 		tools/lra_sweep.py).  The best rated Haptics_dumbModeTick is saved in
+ * 		INFOB and loaded at start up.
+ *
+ ******************************************************************************/
+
+#ifndef LRASWEEP_H_
+#define LRASWEEP_H_
+
+#include "Haptics.h"
+
+#define LRASWEEP_LOW_HZ		145		// First frequency of the sweep
+#define LRASWEEP_HIGH_HZ	220		// Last frequency of the sweep
+#define LRASWEEP_STEP_HZ	5		// Frequency step
+#define LRASWEEP_SIGNATURE	0x1AF0	// Marks valid settings in INFOB
+
+// Haptics_dumbModeTick (LRAFREQ_* half period) of a frequency in Hz
+#define LRASWEEP_HALFPERIOD(hz)	((uint16_t) ((HAPTICS_DUMBTICK_HZ / 2 + (hz) / 2) / (hz)))
+
+/**
+ * LraSweep_Run - sweep the LRA_AUTOOFF carrier frequency and read a rating
+ * 		(decimal number, larger is stronger) after each burst.  The best
+ * 		frequency becomes Haptics_dumbModeTick and is saved.  A line without
+ * 		a number stops the sweep and keeps the old frequency.
+ * @return uint16_t - best frequency in Hz, 0 if stopped or nothing was rated
+ */
+uint16_t LraSweep_Run(void);
+
+/**
+ * LraSweep_Load - set Haptics_dumbModeTick from the saved sweep result
+ * @return uint8_t - 1 if a saved frequency was loaded, 0 if none is saved
+ */
+uint8_t LraSweep_Load(void);
+
+#endif /* LRASWEEP_H_ */
@@ -62,7 +62,7 @@ void Simon_Play(uint8_t button)
 	{
 		Simon_Init();					// Initialize the Simon game settings
 		Simon_IntroSequence();			// Intro Haptics/LED sequence
-		sleep(2500);
+		sleep(TIMER_COUNTS(417));
 		Simon_GeneratePattern();		// Generate Simon pattern
 		Simon_ShowPattern();			// Display the pattern to the user
 	}
@@ -101,42 +101,42 @@ void Simon_IntroSequence(void)
  */
 void Simon_CountDownSequence(void)
 {
-	int delayOn = 5500;
+	uint16_t delayOn = TIMER_COUNTS(917);
 
 	sleep(delayOn);
 
 	CapTouch_ModeLEDsOn();						// Flash mode LEDs
-	Haptics_SendWaveform(COUNTDOWNEFFECT);			// Play Haptics Effect
+	Haptics_SendEffect(COUNTDOWNEFFECT);			// Play Haptics Effect
 	sleep(PATTERNPAUSE);						// Wait while LEDs are on
 	CapTouch_ModeLEDsOff();						// Turn LEDs off
 	sleep(LEDOFFDELAY);							// Wait while LEDs are off
 
 	P3OUT |= MODE3+MODE2+MODE1+MODE0;
-	Haptics_SendWaveform(COUNTDOWNEFFECT);
+	Haptics_SendEffect(COUNTDOWNEFFECT);
 	sleep(PATTERNPAUSE);
 	CapTouch_ModeLEDsOff();
 	sleep(LEDOFFDELAY);
 
 	P3OUT |= MODE2+MODE1+MODE0;
-	Haptics_SendWaveform(COUNTDOWNEFFECT);
+	Haptics_SendEffect(COUNTDOWNEFFECT);
 	sleep(PATTERNPAUSE);
 	CapTouch_ModeLEDsOff();
 	sleep(LEDOFFDELAY);
 
 	P3OUT |= MODE1+MODE0;
-	Haptics_SendWaveform(COUNTDOWNEFFECT);
+	Haptics_SendEffect(COUNTDOWNEFFECT);
 	sleep(PATTERNPAUSE);
 	CapTouch_ModeLEDsOff();
 	sleep(LEDOFFDELAY);
 
 	P3OUT |= MODE0;
-	Haptics_SendWaveform(COUNTDOWNEFFECT);
+	Haptics_SendEffect(COUNTDOWNEFFECT);
 	sleep(PATTERNPAUSE);
 
 	CapTouch_ModeLEDsOff();
 	CapTouch_ButtonLEDsOn();
-	Haptics_SendWaveform(ERROREFFECT);
-	sleep(5000);
+	Haptics_SendEffect(ERROREFFECT);
+	sleep(TIMER_COUNTS(833));
 	CapTouch_ButtonLEDsOff();
 }
 
@@ -146,22 +146,22 @@ void Simon_CountDownSequence(void)
 void Simon_IncorrectSequence(void)
 {
 	// Vibrate motor and blink button LEDs
-	Haptics_SendWaveform(ERROREFFECT);
+	Haptics_SendEffect(ERROREFFECT);
 	CapTouch_FlashButtonLEDs(4);
 	CapTouch_ModeLEDsOff();
-	sleep(5000);
+	sleep(TIMER_COUNTS(833));
 
 	// Scroll mode LEDs
 	CapTouch_ModeLEDsScroll(3);
 	CapTouch_ModeLEDsOff();
-	sleep(5000);
+	sleep(TIMER_COUNTS(833));
 
 	// Display score
 	if(patternLength != MINPATTERNLENGTH + 1)
 		CapTouch_ModeLEDBinary(patternLength - 2);
-	sleep(20000);
+	sleep(TIMER_COUNTS(3333));
 	CapTouch_ModeLEDsOff();
-	sleep(5000);
+	sleep(TIMER_COUNTS(833));
 }
 
 /**
@@ -169,12 +169,12 @@ void Simon_IncorrectSequence(void)
  */
 void Simon_Success(void)
 {
-	sleep(5000);
+	sleep(TIMER_COUNTS(833));
 	CapTouch_ButtonLEDOnSequence();
-	Haptics_SendWaveform(SUCCESSEFFECT);	    // Play haptics effect
+	Haptics_SendEffect(SUCCESSEFFECT);	    // Play haptics effect
 
 	CapTouch_ModeLEDsScroll(5);					// Scroll mode LEDs
-	sleep(5000);
+	sleep(TIMER_COUNTS(833));
 	CapTouch_ButtonLEDOffSequence();
 }
 
@@ -185,14 +185,12 @@ void Simon_GeneratePattern(void)
 {
 	unsigned int i = 0;
 
-	srand(CapTouch_RandomNumber);	// random number generator seed
+	srand((unsigned int) Timer_Uptime());	// seed with the time the user took to start
 
 	for(i = 0; i < MAXPATTERNLENGTH; i++)
 	{
 		pattern[i] = (rand() % NUMBUTTONS);		// create a pattern selecting one button for each value
 	}
-
-	CapTouch_RandomNumber = 0;
 }
 
 /**
@@ -201,6 +199,7 @@ void Simon_GeneratePattern(void)
 void Simon_ShowPattern(void)
 {
 	unsigned int i = 0;
+	uint32_t deadline;
 
 	if(patternLength == MINPATTERNLENGTH)
 	{
@@ -209,15 +208,18 @@ void Simon_ShowPattern(void)
 
 	CapTouch_ButtonLEDsOff();
 
-	sleep(10000);
+	deadline = Timer_Uptime() + TIMER_COUNTS(1667);
+	Timer_SleepUntil(deadline);
 
 	for(i = 0; i < patternLength; i++)			// go through the pattern
 	{
 		CapTouch_ButtonLEDsOff();
 		buttonEffects[(pattern[i])]();			// call the appropriate button function
-		sleep(PATTERNPAUSE);					// pause between patterns
+		deadline += PATTERNPAUSE;				// pause between patterns, the effect time included
+		Timer_SleepUntil(deadline);
 		CapTouch_ButtonLEDsOff();
-		sleep(LEDOFFDELAY);
+		deadline += LEDOFFDELAY;
+		Timer_SleepUntil(deadline);
 	}
 
 	Simon_isPatternDisplayed = 1;				// the pattern has been displayed
@@ -270,7 +272,7 @@ void Simon_EffectButton1(void)
 {
 	P1OUT |= BUTTON1;							// turn on B1 LED
 
-	Haptics_SendWaveform(B1EFFECT);				// Play Haptic Effect
+	Haptics_QueueEffect(B1EFFECT, HAPTICS_PRIORITY_HIGH);	// Play Haptic Effect, cancels alerts
 }
 
 /**
@@ -280,7 +282,7 @@ void Simon_EffectButton2(void)
 {
 	P1OUT |= BUTTON2;							// turn on B2 LED
 
-	Haptics_SendWaveform(B2EFFECT);				// Play Haptic Effect
+	Haptics_QueueEffect(B2EFFECT, HAPTICS_PRIORITY_HIGH);	// Play Haptic Effect, cancels alerts
 }
 
 /**
@@ -290,7 +292,7 @@ void Simon_EffectButton3(void)
 {
 	P1OUT |= BUTTON3;							// turn on B3 LED
 
-	Haptics_SendWaveform(B3EFFECT);				// Play Haptic Effect
+	Haptics_QueueEffect(B3EFFECT, HAPTICS_PRIORITY_HIGH);	// Play Haptic Effect, cancels alerts
 }
 
 /**
@@ -300,7 +302,7 @@ void Simon_EffectButton4(void)
 {
 	P1OUT |= BUTTON4;							// turn on B4 LED
 
-	Haptics_SendWaveform(B4EFFECT);				// Play Haptic Effect
+	Haptics_QueueEffect(B4EFFECT, HAPTICS_PRIORITY_HIGH);	// Play Haptic Effect, cancels alerts
 }
 
 
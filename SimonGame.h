@@ -19,7 +19,8 @@
  * 			game is over.
  *
  *
- * @TODO - Update this file when changing actuators types (ERM, LRA, Piezo)
+ * The button effects below are for the LRA, use the EFFECT_ERM_ effects for
+ * an ERM.  Haptics_SetPiezo plays either set on a piezo.
  ******************************************************************************/
 
 #ifndef SIMONGAME_H_
@@ -32,19 +33,19 @@
 // Settings
 #define MINPATTERNLENGTH 	1				// Minimum pattern length
 #define MAXPATTERNLENGTH 	50				// Maximum pattern length
-#define PATTERNPAUSE 		2000			// Maximum time to pause before next pattern signal is shown
+#define PATTERNPAUSE 		TIMER_COUNTS(333)	// Maximum time to pause before next pattern signal is shown
 #define NUMBUTTONS 			NUMBER_BUTTONS	// Number of buttons used in Simon pattern
-#define LEDOFFDELAY 		1500			// Time LEDs flash off during sequencing and patterns
+#define LEDOFFDELAY 		TIMER_COUNTS(250)	// Time LEDs flash off during sequencing and patterns
 
 
-// @TODO Update the effects below when changing actuators (ERM, LRA, Piezo)
-#define B1EFFECT 			lra_click				// Effect for button 1
-#define B2EFFECT 			lra_softclick			// Effect for button 2
-#define B3EFFECT 			lra_softbump			// Effect for button 3
-#define B4EFFECT 			lra_tick				// Effect for button 4
-#define COUNTDOWNEFFECT		lra_tick				// Effect for Simon Countdown sequence
-#define ERROREFFECT			erm_alert				// Effect for Simon error sequence
-#define SUCCESSEFFECT		lra_rampupdoubleclick	// Effect for Simon success sequence
+// Button effects, EFFECT_LRA_ for the LRA or EFFECT_ERM_ for an ERM
+#define B1EFFECT 			EFFECT_LRA_CLICK				// Effect for button 1
+#define B2EFFECT 			EFFECT_LRA_SOFTCLICK			// Effect for button 2
+#define B3EFFECT 			EFFECT_LRA_SOFTBUMP				// Effect for button 3
+#define B4EFFECT 			EFFECT_LRA_TICK					// Effect for button 4
+#define COUNTDOWNEFFECT		EFFECT_LRA_TICK					// Effect for Simon Countdown sequence
+#define ERROREFFECT			EFFECT_ERM_ALERT				// Effect for Simon error sequence
+#define SUCCESSEFFECT		EFFECT_LRA_RAMPUPDOUBLECLICK	// Effect for Simon success sequence
 
 /**
  * Simon_Init - Initialize Simon status and variables
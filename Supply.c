@@ -0,0 +1,165 @@
+/******************************************************************************
+ * Supply.c
+ *
+ * Created on: Oct 19, 2026
+ * Board: DRV2603EVM-CT RevD
+ *
+ * Desc: This file contains the supply voltage measurement, ADC10 channel 11
+ * 		(VCC/2) against the internal 2.5V reference, or the 1.5V reference
+ * 		when VCC is below 3V where the 2.5V reference is out of range.  The
+ * 		reference and the ADC are only on during a measurement.
+ *
+ ******************************************************************************/
+
+#include "Supply.h"
+
+// Supply_Poll states
+#define SUPPLY_IDLE			0
+#define SUPPLY_SETTLING		1		// reference on, convert at the next poll
+#define SUPPLY_CONVERTING	2
+
+// private variables
+static uint16_t settleLoops = 30;	// SUPPLY_REFSETTLE_US in 8 cycle loops, 8MHz until Supply_Init
+static uint8_t supplyState;
+static uint16_t supplyReference;	// REF2_5V or 0 for the 1.5V reference
+
+// private functions
+static void Supply_Power(uint16_t reference);
+static uint16_t Supply_Read(void);
+static uint16_t Supply_Convert(uint16_t reference);
+static uint16_t Supply_Millivolts(uint16_t reference, uint16_t sample);
+
+/**
+ * Supply_Init - set the reference settling delay of Supply_Measure
+ * @param uint32_t mclkHz - MCLK frequency
+ */
+void Supply_Init(uint32_t mclkHz)
+{
+	settleLoops = (uint16_t) ((mclkHz / 1000000UL * SUPPLY_REFSETTLE_US + 7) / 8);
+	if(!settleLoops)
+		settleLoops = 1;
+}
+
+/**
+ * Supply_Measure - measure VCC, waits ~110us for the conversion, ~220us
+ * 		below 3V.  Cancels a measurement started by Supply_Start.
+ * @return uint16_t - VCC in mV
+ */
+uint16_t Supply_Measure(void)
+{
+	uint16_t millivolts;
+
+	Supply_Cancel();
+	millivolts = Supply_Millivolts(REF2_5V, Supply_Convert(REF2_5V));
+	if(millivolts < 3000)
+		millivolts = Supply_Millivolts(0, Supply_Convert(0));
+	return millivolts;
+}
+
+/**
+ * Supply_Start - switch on the reference and the ADC for Supply_Poll
+ */
+void Supply_Start(void)
+{
+	Supply_Power(REF2_5V);
+	supplyState = SUPPLY_SETTLING;
+}
+
+/**
+ * Supply_Poll - advance the measurement started by Supply_Start without
+ * 		waiting.  Call at intervals longer than SUPPLY_REFSETTLE_US and the
+ * 		conversion (~110us), e.g. once per player tick.
+ * @return uint16_t - VCC in mV when the measurement is done, 0 while busy or idle
+ */
+uint16_t Supply_Poll(void)
+{
+	uint16_t millivolts;
+
+	switch(supplyState)
+	{
+	case SUPPLY_SETTLING:
+		ADC10CTL0 |= ENC + ADC10SC;
+		supplyState = SUPPLY_CONVERTING;
+		return 0;
+	case SUPPLY_CONVERTING:
+		if(ADC10CTL1 & ADC10BUSY)
+			return 0;
+		millivolts = Supply_Millivolts(supplyReference, Supply_Read());
+		if(supplyReference && (millivolts < 3000))
+		{
+			Supply_Power(0);					// Again with the 1.5V reference
+			supplyState = SUPPLY_SETTLING;
+			return 0;
+		}
+		Supply_Cancel();
+		return millivolts;
+	default:
+		return 0;
+	}
+}
+
+/**
+ * Supply_Cancel - stop a measurement started by Supply_Start, reference and
+ * 		ADC off
+ */
+void Supply_Cancel(void)
+{
+	ADC10CTL0 &= ~ENC;
+	ADC10CTL0 = 0;
+	supplyState = SUPPLY_IDLE;
+}
+
+/*
+ * Supply_Power - switch on the reference and the ADC for a VCC/2 conversion
+ * @param uint16_t reference - REF2_5V for the 2.5V reference, 0 for 1.5V
+ */
+static void Supply_Power(uint16_t reference)
+{
+	ADC10CTL0 &= ~ENC;
+	ADC10CTL1 = INCH_11 + ADC10DIV_3;							// VCC/2, ADC10OSC/4
+	ADC10CTL0 = SREF_1 + ADC10SHT_3 + REFON + reference + ADC10ON;	// 64 clock sample
+	supplyReference = reference;
+}
+
+/*
+ * Supply_Read - read the finished conversion
+ * @return uint16_t - ADC10 result, 0-1023 of the reference
+ */
+static uint16_t Supply_Read(void)
+{
+	uint16_t sample = ADC10MEM;
+
+	ADC10CTL0 &= ~ENC;
+	return sample;
+}
+
+/*
+ * Supply_Convert - one VCC/2 conversion, waits for the reference and the ADC
+ * @param uint16_t reference - REF2_5V for the 2.5V reference, 0 for 1.5V
+ * @return uint16_t - ADC10 result, 0-1023 of the reference
+ */
+static uint16_t Supply_Convert(uint16_t reference)
+{
+	uint16_t sample;
+	uint16_t i;
+
+	Supply_Power(reference);
+	for(i = settleLoops; i; i--)
+		__delay_cycles(8);
+	ADC10CTL0 |= ENC + ADC10SC;
+	while(ADC10CTL1 & ADC10BUSY);
+	sample = Supply_Read();
+	ADC10CTL0 = 0;												// Reference and ADC off
+	return sample;
+}
+
+/*
+ * Supply_Millivolts - VCC from a VCC/2 conversion, 2 * reference * sample / 1024
+ * @param uint16_t reference - REF2_5V for the 2.5V reference, 0 for 1.5V
+ * @param uint16_t sample - ADC10 result
+ * @return uint16_t - VCC in mV
+ */
+static uint16_t Supply_Millivolts(uint16_t reference, uint16_t sample)
+{
+	return (uint16_t) (((uint32_t) sample * (reference ? 5000 : 3000) + 512) >> 10);
+}
@@ -0,0 +1,57 @@
+/******************************************************************************
+ * Supply.h
+ *
+ * Created on: Oct 19, 2026
+ * Board: DRV2603EVM-CT RevD
+ *
+ * Desc: This file contains the supply voltage measurement, ADC10 channel 11
+ * 		(VCC/2) against the internal 2.5V reference, or the 1.5V reference
+ * 		when VCC is below 3V where the 2.5V reference is out of range.  The
+ * 		reference and the ADC are only on during a measurement.
+ *
+ * 		Supply_Measure waits for the conversions.  From an ISR use
+ * 		Supply_Start and Supply_Poll, which never wait for the ADC.
+ *
+ ******************************************************************************/
+
+#ifndef SUPPLY_H_
+#define SUPPLY_H_
+
+#include "msp430.h"
+#include <stdint.h>
+
+#define SUPPLY_REFSETTLE_US	30		// Reference settling time
+
+/**
+ * Supply_Init - set the reference settling delay of Supply_Measure
+ * @param uint32_t mclkHz - MCLK frequency
+ */
+void Supply_Init(uint32_t mclkHz);
+
+/**
+ * Supply_Measure - measure VCC, waits ~110us for the conversion, ~220us
+ * 		below 3V.  Cancels a measurement started by Supply_Start.
+ * @return uint16_t - VCC in mV
+ */
+uint16_t Supply_Measure(void);
+
+/**
+ * Supply_Start - switch on the reference and the ADC for Supply_Poll
+ */
+void Supply_Start(void);
+
+/**
+ * Supply_Poll - advance the measurement started by Supply_Start without
+ * 		waiting.  Call at intervals longer than SUPPLY_REFSETTLE_US and the
+ * 		conversion (~110us), e.g. once per player tick.
+ * @return uint16_t - VCC in mV when the measurement is done, 0 while busy or idle
+ */
+uint16_t Supply_Poll(void);
+
+/**
+ * Supply_Cancel - stop a measurement started by Supply_Start, reference and
+ * 		ADC off
+ */
+void Supply_Cancel(void);
+
+#endif /* SUPPLY_H_ */
@@ -7,30 +7,318 @@
 
 #include "Timer.h"
 
+static SoftTimer* timerList;		// running timers, first to expire first
+static volatile uint16_t timerOverflows;	// TA0R overflows, high word of the uptime
+static uint16_t borrowCCTL0;		// TA0CCTL0 while the HAL has TA0
+static uint32_t borrowUptime;		// uptime when the HAL took TA0
+static uint16_t borrowCycles;		// SMCLK cycles of measurements not yet added to TA0R
+static uint8_t  borrowed;			// the HAL has TA0
+
+// public variables
+uint16_t Timer_aclkHz;
+uint16_t Timer_smclkPerCount;
+
+static void Timer_Insert(SoftTimer* timer);
+static void Timer_Remove(SoftTimer* timer);
+static void Timer_Program(void);
+
+/**
+ * Timer_Init - measure ACLK against SMCLK, then start Timer0_A counting ACLK
+ * 		in continuous mode
+ * @param uint32_t smclkHz - SMCLK frequency
+ */
+void Timer_Init(uint32_t smclkHz)
+{
+    uint32_t cycles = 0;
+    uint16_t last;
+    uint8_t i;
+
+    // Capture the rising ACLK edges (CCI0B) on SMCLK, each period is below
+    // 65536 SMCLK cycles down to the slowest VLO
+    TA0CCTL0 = 0;
+    TA0CTL = TASSEL_2+MC_2+TACLR;           // SMCLK, continuous mode
+    TA0CCTL0 = CM_1+CCIS_1+SCS+CAP;         // Rising edge, ACLK, synchronous capture
+    while(!(TA0CCTL0 & CCIFG));
+    last = TA0CCR0;
+    for(i = 0; i < TIMER_ACLK_PERIODS; i++)
+    {
+        TA0CCTL0 &= ~CCIFG;
+        while(!(TA0CCTL0 & CCIFG));
+        cycles += (uint16_t) (TA0CCR0 - last);
+        last = TA0CCR0;
+    }
+    Timer_aclkHz = (uint16_t) ((smclkHz * TIMER_ACLK_PERIODS + cycles / 2) / cycles);
+    Timer_smclkPerCount = (uint16_t) ((cycles + TIMER_ACLK_PERIODS / 2) / TIMER_ACLK_PERIODS);
+
+    timerList = 0;
+    timerOverflows = 0;
+    TA0CCTL0 = 0;
+    TA0CTL = TASSEL_1+MC_2+TACLR+TAIE;      // ACLK, continuous mode, count overflows
+}
+
+/**
+ * Timer_Now - read the free-running count
+ * @return uint16_t - TA0R
+ */
+uint16_t Timer_Now(void)
+{
+    uint16_t count;
+
+    do
+    {
+        count = TA0R;                       // Majority read, ACLK is asynchronous
+    } while(count != TA0R);
+    return count;
+}
+
+/**
+ * Timer_Uptime - read the monotonic 32-bit count since Timer_Init
+ * @return uint32_t - ACLK counts, see TIMER_COUNTS
+ */
+uint32_t Timer_Uptime(void)
+{
+    uint16_t contextSaveSR = __get_SR_register();
+    uint16_t high;
+    uint16_t low;
+
+    if(borrowed)
+        return borrowUptime;                // TA0 counts the touch oscillator
+
+    __bic_SR_register(GIE);
+    low = Timer_Now();
+    high = timerOverflows;
+    if((TA0CTL & TAIFG) && (low < 0x8000))
+        high++;                             // Overflowed, the ISR has not run yet
+    if(contextSaveSR & GIE)
+        __bis_SR_register(GIE);
+    return ((uint32_t) high << 16) | low;
+}
+
 /**
- * timerdelay - timer used for haptics effects
+ * Timer_Milliseconds - uptime in ms
+ * @return uint32_t - ms since Timer_Init
+ */
+uint32_t Timer_Milliseconds(void)
+{
+    uint32_t uptime = Timer_Uptime();
+
+    return (uptime / Timer_aclkHz) * 1000 + (uptime % Timer_aclkHz) * 1000 / Timer_aclkHz;
+}
+
+/**
+ * Timer_SleepUntil - sleep in LPM0 until an uptime
+ * @param uint32_t deadline - Timer_Uptime count to wake at
+ */
+void Timer_SleepUntil(uint32_t deadline)
+{
+    int32_t remaining;
+
+    while((remaining = (int32_t) (deadline - Timer_Uptime())) > 0)
+        sleep((remaining > TIMER_MAXDELAY) ? TIMER_MAXDELAY : (uint16_t) remaining);
+}
+
+/**
+ * Timer_Start - start or restart a software timer
+ * @param SoftTimer* timer - the timer, must stay valid while it runs
+ * @param uint16_t delay - counts to the first expiry, 1-TIMER_MAXDELAY
+ * @param uint16_t period - counts between later expiries, 0 = one-shot
+ * @param Timer_Callback callback - called at each expiry, 0 = none
+ */
+void Timer_Start(SoftTimer* timer, uint16_t delay, uint16_t period, Timer_Callback callback)
+{
+    uint16_t contextSaveSR = __get_SR_register();
+
+    __bic_SR_register(GIE);
+    if(timer->running)
+        Timer_Remove(timer);
+    if(!delay)
+        delay = 1;
+    if(delay > TIMER_MAXDELAY)
+        delay = TIMER_MAXDELAY;
+    if(period > TIMER_MAXDELAY)
+        period = TIMER_MAXDELAY;
+    timer->expiry = Timer_Now() + delay;
+    timer->period = period;
+    timer->callback = callback;
+    timer->expired = 0;
+    Timer_Insert(timer);
+    Timer_Program();
+    if(contextSaveSR & GIE)
+        __bis_SR_register(GIE);
+}
+
+/**
+ * Timer_Stop - stop a software timer
+ * @param SoftTimer* timer - the timer
+ */
+void Timer_Stop(SoftTimer* timer)
+{
+    uint16_t contextSaveSR = __get_SR_register();
+
+    __bic_SR_register(GIE);
+    if(timer->running)
+    {
+        Timer_Remove(timer);
+        Timer_Program();
+    }
+    if(contextSaveSR & GIE)
+        __bis_SR_register(GIE);
+}
+
+/**
+ * Timer_Borrow - hand TA0 to the capacitive touch HAL for a measurement
+ */
+void Timer_Borrow(void)
+{
+    borrowUptime = Timer_Uptime();
+    borrowed = 1;
+    borrowCCTL0 = TA0CCTL0;
+    TA0CCTL0 &= ~CCIE;                      // No expiries while TA0 counts the oscillator
+}
+
+/**
+ * Timer_Return - take TA0 back after a measurement
+ * @param uint32_t smclkCycles - length of the measurement in SMCLK cycles
+ */
+void Timer_Return(uint32_t smclkCycles)
+{
+    uint16_t contextSaveSR = __get_SR_register();
+    uint16_t counts;
+    uint32_t uptime;
+
+    __bic_SR_register(GIE);
+    smclkCycles += borrowCycles;            // Keep the fraction of a count for the next scan
+    counts = (uint16_t) (smclkCycles / Timer_smclkPerCount);
+    borrowCycles = (uint16_t) (smclkCycles - (uint32_t) counts * Timer_smclkPerCount);
+    uptime = borrowUptime + counts;
+
+    TA0CTL &= ~MC_3;                        // Halt to write TAR
+    TA0R = (uint16_t) uptime;
+    timerOverflows = (uint16_t) (uptime >> 16);
+    TA0CTL = TASSEL_1+MC_2+TAIE;            // Drops the overflows of the measurement
+    TA0CCTL0 = borrowCCTL0 & ~CCIFG;        // Drop compares made while measuring
+    borrowed = 0;
+    Timer_Program();
+    if(contextSaveSR & GIE)
+        __bis_SR_register(GIE);
+}
+
+/**
+ * timerdelay - delay on the timer service
+ * @param unsigned int delay - SMCLK cycles, rounded to timer counts
  */
 void timerdelay(unsigned int tdelay)
 {
-    TA0CCR0 = tdelay;
-    TA0CTL = MC_1+TACLR+TASSEL_2;
-    TA0CCTL0 &= ~CCIFG;
-    TA0CCTL0 |= CCIE;
-    __bis_SR_register(LPM0_bits + GIE);
-    //__bis_SR_register(LPM0_bits);
-    __no_operation();
+    sleep(((uint32_t) tdelay + Timer_smclkPerCount / 2) / Timer_smclkPerCount);
 }
 
 /**
- * sleep - sleep for a fixed time
- * @param uint16_t time
+ * sleep - sleep in LPM0 for a fixed time
+ * @param uint16_t time - ACLK counts, see TIMER_COUNTS
  */
 void sleep(uint16_t time)
 {
-    TA0CCR0 = time;
-    TA0CTL = MC_1+TACLR+TASSEL_1;
-    TA0CCTL0 &= ~CCIFG;
-    TA0CCTL0 |= CCIE;
-    __bis_SR_register(LPM0_bits+GIE);
-    __no_operation();
+    SoftTimer timer;
+
+    timer.running = 0;
+    Timer_Start(&timer, time, 0, 0);
+    __bic_SR_register(GIE);
+    while(!timer.expired)
+    {
+        __bis_SR_register(LPM0_bits+GIE);   // Woken by any expiry or other interrupt
+        __bic_SR_register(GIE);
+    }
+    __bis_SR_register(GIE);
+}
+
+/*
+ * Timer_Insert - insert a timer behind all timers that expire before or with it
+ * @param SoftTimer* timer - timer with its expiry set
+ */
+static void Timer_Insert(SoftTimer* timer)
+{
+    SoftTimer** link = &timerList;
+    uint16_t now = Timer_Now();
+    uint16_t due = timer->expiry - now;
+
+    while(*link && ((int16_t) ((*link)->expiry - now) <= (int16_t) due))
+        link = &(*link)->next;
+    timer->next = *link;
+    *link = timer;
+    timer->running = 1;
+}
+
+/*
+ * Timer_Remove - take a running timer out of the list
+ * @param SoftTimer* timer - the timer
+ */
+static void Timer_Remove(SoftTimer* timer)
+{
+    SoftTimer** link = &timerList;
+
+    while(*link && (*link != timer))
+        link = &(*link)->next;
+    if(*link)
+        *link = timer->next;
+    timer->running = 0;
+}
+
+/*
+ * Timer_Program - set CCR0 to the first expiry, or disable it when no timer
+ * 		runs.  An expiry that is already due is raised in software, the
+ * 		compare only fires when TA0R reaches CCR0.
+ */
+static void Timer_Program(void)
+{
+    if(!timerList)
+    {
+        TA0CCTL0 &= ~CCIE;
+        return;
+    }
+    if(borrowed)
+        return;                             // See Timer_Return
+    TA0CCR0 = timerList->expiry;
+    TA0CCTL0 = CCIE;
+    if((int16_t) (timerList->expiry - Timer_Now()) <= 0)
+        TA0CCTL0 |= CCIFG;
+}
+
+/*
+ * Timer_A0_ISR - run the callbacks of the expired timers, reinsert periodic
+ * 		timers and wake the CPU
+ */
+#pragma vector=TIMER0_A0_VECTOR
+__interrupt void Timer_A0_ISR(void)
+{
+    SoftTimer* timer;
+    uint16_t now = Timer_Now();
+
+    while(timerList && ((int16_t) (now - timerList->expiry) >= 0))
+    {
+        timer = timerList;
+        timerList = timer->next;
+        timer->running = 0;
+        if(timer->period)
+        {
+            timer->expiry += timer->period; // No drift, a late expiry is caught up
+            Timer_Insert(timer);
+        }
+        timer->expired = 1;
+        if(timer->callback)
+            timer->callback(timer);
+    }
+    Timer_Program();
+
+    __bic_SR_register_on_exit(LPM0_bits);   // Keep GIE, the haptics player runs in the background
+}
+
+/*
+ * Timer_A1_ISR - count TA0R overflows for Timer_Uptime, the CCR1 and CCR2
+ * 		interrupts are not used
+ */
+#pragma vector=TIMER0_A1_VECTOR
+__interrupt void Timer_A1_ISR(void)
+{
+    if(TA0IV == TA0IV_TAIFG)
+        timerOverflows++;
 }
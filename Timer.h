@@ -3,6 +3,30 @@
  *
  *  Created on: Jan 30, 2012
  *      Author: a0866685
+ *
+ *  Timer service: Timer0_A counts ACLK in continuous mode and is never
+ *  stopped or cleared.  Software timers are kept in a list sorted by expiry,
+ *  CCR0 is set to the first one.  sleep(), timerdelay() and any module that
+ *  needs a timeout or a periodic callback share TA0 through this service.
+ *  The capacitive touch HAL borrows TA0 for each scan (Timer_Borrow,
+ *  Timer_Return), the service adds the scan time back afterwards.
+ *
+ *  ACLK is VLO / 2 (main.c), nominally 6kHz but the VLO varies +-50% between
+ *  parts and with temperature.  Timer_Init measures it against SMCLK, which
+ *  runs from the calibrated DCO, and the conversions use the measured rate.
+ *
+ *  The scan time is what the HAL counts (gate or oscillator time) plus its
+ *  overhead estimated from the code (CTS_HAL.c).  The estimate is good to
+ *  about +-40 SMCLK cycles per element, +-6% of a WDTp_GATE_512 element at
+ *  8MHz and under 1% with WDTp_GATE_8192.  Not counted: interrupts that hold
+ *  off the gate interrupt or run between the gates (the haptics player ISR
+ *  while the PWM runs, up to about one run per element), the fraction of a
+ *  count TA0R held at Timer_Borrow (up to one count per scan) and VLO drift
+ *  since Timer_Init.  Apart from the estimate, these make the service run slow.
+ *
+ *  TA0 overflows extend the count to a 32-bit uptime (Timer_Uptime) that
+ *  wraps after 2^32 counts, 8.3 days at 6kHz.  Compare uptimes by subtraction, e.g.
+ *  (Timer_Uptime() - start >= TIMER_COUNTS(600)), so the wrap is harmless.
  */
 
 #ifndef TIMER_H_
@@ -10,17 +34,108 @@
 
 #include "CTS/structure.h"
 
+#define TIMER_ACLK_PERIODS		8		// ACLK periods Timer_Init measures
+#define TIMER_MAXDELAY			0x7FFF	// Longest delay or period in counts (5.4s at 6kHz)
+
+// Timer counts in ms, rounded.  Delays and periods are at most TIMER_MAXDELAY,
+// uptime differences and deadlines may be longer.
+#define TIMER_COUNTS(ms)		(((uint32_t) (ms) * Timer_aclkHz + 500) / 1000)
+
+extern uint16_t Timer_aclkHz;				// measured ACLK, counts per second, set by Timer_Init
+extern uint16_t Timer_smclkPerCount;		// SMCLK cycles per count, set by Timer_Init
+
+struct Timer_Soft;
+
+// Called from the TIMER0_A0 ISR with interrupts disabled, keep it short.
+// The timer may be started or stopped again from its callback.
+typedef void (*Timer_Callback)(struct Timer_Soft* timer);
+
+// Software Timer Type Definition, owned by the caller.  Zero it before the
+// first Timer_Start and leave it untouched while it is running.
+typedef struct Timer_Soft {
+	struct Timer_Soft*		next;				// next timer to expire
+	uint16_t				expiry;				// TA0R count of the next expiry
+	uint16_t				period;				// counts between periodic expiries, 0 = one-shot
+	Timer_Callback			callback;			// called at each expiry, 0 = none
+	volatile uint8_t		expired;			// set at each expiry, cleared by Timer_Start
+	uint8_t					running;			// the timer is in the list
+} SoftTimer;
+
+/**
+ * Timer_Init - measure ACLK against SMCLK, then start Timer0_A counting ACLK
+ * 		in continuous mode.  Call before any other timer function, takes
+ * 		TIMER_ACLK_PERIODS ACLK periods (1.3ms at 6kHz).
+ * @param uint32_t smclkHz - SMCLK frequency, see Haptics_smclkHz
+ */
+void Timer_Init(uint32_t smclkHz);
+
+/**
+ * Timer_Now - read the free-running count, consistent although ACLK is
+ * 		asynchronous to MCLK
+ * @return uint16_t - TA0R, wraps every 65536 counts
+ */
+uint16_t Timer_Now(void);
+
+/**
+ * Timer_Uptime - read the monotonic 32-bit count since Timer_Init, the
+ * 		overflows of TA0R in the high word.  Safe to call from any context.
+ * @return uint32_t - ACLK counts, see TIMER_COUNTS
+ */
+uint32_t Timer_Uptime(void);
+
 /**
- * timerdelay - 5ms timer delay
- * @param unsigned int delay
+ * Timer_Milliseconds - uptime in ms
+ * @return uint32_t - ms since Timer_Init, wraps with the uptime
+ */
+uint32_t Timer_Milliseconds(void);
+
+/**
+ * Timer_SleepUntil - sleep in LPM0 until an uptime, returns at once if it
+ * 		has passed.  A sequence paced with deadlines does not drift by the
+ * 		time spent between the waits.
+ * @param uint32_t deadline - Timer_Uptime count to wake at
+ */
+void Timer_SleepUntil(uint32_t deadline);
+
+/**
+ * Timer_Start - start or restart a software timer.  Every expiry sets
+ * 		timer->expired, calls the callback and wakes the CPU from LPM0.
+ * @param SoftTimer* timer - the timer, must stay valid while it runs
+ * @param uint16_t delay - counts to the first expiry, 1-TIMER_MAXDELAY
+ * @param uint16_t period - counts between later expiries, 0 = one-shot
+ * @param Timer_Callback callback - called at each expiry, 0 = none
+ */
+void Timer_Start(SoftTimer* timer, uint16_t delay, uint16_t period, Timer_Callback callback);
+
+/**
+ * Timer_Stop - stop a software timer, nothing happens if it is not running
+ * @param SoftTimer* timer - the timer
+ */
+void Timer_Stop(SoftTimer* timer);
+
+/**
+ * Timer_Borrow - hand TA0 to the capacitive touch HAL for a measurement.
+ * 		The software timers are held until Timer_Return.
+ */
+void Timer_Borrow(void);
+
+/**
+ * Timer_Return - take TA0 back after a measurement.  Call after the HAL has
+ * 		restored TA0CTL; the count is moved on by the measurement time.
+ * @param uint32_t smclkCycles - length of the measurement in SMCLK cycles
+ */
+void Timer_Return(uint32_t smclkCycles);
+
+/**
+ * timerdelay - delay on the timer service
+ * @param unsigned int delay - SMCLK cycles, rounded to timer counts
  */
 void timerdelay(unsigned int tdelay);
 
 /**
- * sleep - sleep for a fixed time
- * @param uint16_t time
+ * sleep - sleep in LPM0 for a fixed time, other software timers keep running
+ * @param uint16_t time - ACLK counts, see TIMER_COUNTS
  */
 void sleep(uint16_t time);
 
 #endif /* TIMER_H_ */
-
@@ -0,0 +1,215 @@
+/******************************************************************************
+ * Uart.c
+ *
+ * Created on: Oct 19, 2026
+ * Board: DRV2603EVM-CT RevD
+ *
+ * Desc: This file contains the USCI_A0 UART functions used for the serial
+ * 		console (9600 bps, see main.c for the UART setup).  Received bytes
+ * 		are buffered by the RX interrupt.
+ *
+ ******************************************************************************/
+
+#include "Uart.h"
+
+// receive ring buffer, the indices run freely and are masked on access
+static volatile char rxBuffer[UART_RXBUFFERSIZE];
+static volatile uint8_t rxHead;			// written by the RX ISR
+static volatile uint8_t rxTail;			// read by Uart_Read
+static volatile uint8_t rxWaiting;		// Uart_WaitRead is sleeping
+static volatile Uart_Receiver rxReceiver;	// bypasses the buffer when set
+
+/**
+ * getc - output a single character (legacy name)
+ * @param char c - character to send
+ */
+void getc(char c)
+{
+	while((UCA0STAT & UCBUSY));
+	{
+	UCA0RXBUF = c;
+	}
+}
+
+/**
+ * write - output a single character
+ * @param char ch - character to send
+ */
+void write(char ch)
+{
+	while ((UCA0STAT & UCBUSY));
+	{
+				UCA0TXBUF  = ch;
+	}
+}
+
+/**
+ * printf - output a zero terminated string
+ * @param char * tx_data - string to send
+ */
+void printf(char * tx_data)
+{
+    unsigned int i=0;
+    while(tx_data[i])
+    {
+        while ((UCA0STAT & UCBUSY));
+        UCA0TXBUF = tx_data[i];
+        i++;
+    }
+}
+
+/**
+ * Uart_PrintNumber - output an unsigned number in decimal
+ * @param uint16_t number - number to send
+ */
+void Uart_PrintNumber(uint16_t number)
+{
+	char digits[6];
+	uint8_t i = sizeof(digits) - 1;
+
+	digits[i] = 0;
+	do
+	{
+		digits[--i] = '0' + (number % 10);
+		number = number / 10;
+	} while(number);
+
+	printf(&digits[i]);
+}
+
+/**
+ * Uart_Available - number of received bytes waiting to be read
+ * @return uint8_t - bytes in the receive buffer
+ */
+uint8_t Uart_Available(void)
+{
+	return (uint8_t) (rxHead - rxTail);
+}
+
+/**
+ * Uart_Read - read a received byte without waiting
+ * @return char - the byte, 0 if nothing was received
+ */
+char Uart_Read(void)
+{
+	char c;
+
+	if(rxHead == rxTail)
+		return 0;
+
+	c = rxBuffer[rxTail & (UART_RXBUFFERSIZE - 1)];
+	rxTail++;
+	return c;
+}
+
+/**
+ * Uart_WaitRead - sleep in LPM0 until a byte is received and read it
+ * @return char - the byte
+ */
+char Uart_WaitRead(void)
+{
+	__bic_SR_register(GIE);
+	while(rxHead == rxTail)
+	{
+		rxWaiting = 1;
+		__bis_SR_register(LPM0_bits + GIE);		// Woken by the RX ISR
+		__bic_SR_register(GIE);
+	}
+	rxWaiting = 0;
+	__bis_SR_register(GIE);
+
+	return Uart_Read();
+}
+
+/**
+ * Uart_SetReceiver - pass received bytes to a handler in the RX ISR instead of
+ * 		the receive buffer
+ * @param Uart_Receiver receiver - handler, 0 = use the receive buffer again
+ */
+void Uart_SetReceiver(Uart_Receiver receiver)
+{
+	rxReceiver = receiver;
+}
+
+/**
+ * Uart_ReadNumber - read and echo a decimal number, leading spaces and commas
+ * 		are skipped
+ * @param char* end - set to the character that ended the number
+ * @return uint16_t - the number, UART_NONUMBER if no digits were read
+ */
+uint16_t Uart_ReadNumber(char* end)
+{
+	uint16_t number = UART_NONUMBER;
+	char c;
+
+	do
+	{
+		c = Uart_WaitRead();
+		write(c);
+	} while((c == ' ') || (c == ','));
+
+	while((c >= '0') && (c <= '9'))
+	{
+		if(number == UART_NONUMBER)
+			number = 0;
+		number = number * 10 + (c - '0');
+		c = Uart_WaitRead();
+		write(c);
+	}
+
+	*end = c;
+	return number;
+}
+
+/**
+ * Uart_ReadWord - read and echo a word, leading spaces and commas are skipped
+ * @param char* word - buffer, the word is zero terminated and cut to size - 1 characters
+ * @param uint8_t size - size of the buffer
+ * @return char - the character that ended the word
+ */
+char Uart_ReadWord(char* word, uint8_t size)
+{
+	uint8_t i = 0;
+	char c;
+
+	do
+	{
+		c = Uart_WaitRead();
+		write(c);
+	} while((c == ' ') || (c == ','));
+
+	while((c != ' ') && (c != ',') && (c != '\r') && (c != '\n'))
+	{
+		if(i < size - 1)
+			word[i++] = c;
+		c = Uart_WaitRead();
+		write(c);
+	}
+
+	word[i] = 0;
+	return c;
+}
+
+/*
+ * Uart_RX_ISR - pass a received byte to the receiver or store it, it is
+ * 		dropped when the buffer is full
+ */
+#pragma vector=USCIAB0RX_VECTOR
+__interrupt void Uart_RX_ISR(void)
+{
+	char c = UCA0RXBUF;
+
+	if(rxReceiver)
+	{
+		rxReceiver((uint8_t) c);
+		return;
+	}
+
+	if((uint8_t) (rxHead - rxTail) < UART_RXBUFFERSIZE)
+	{
+		rxBuffer[rxHead & (UART_RXBUFFERSIZE - 1)] = c;
+		rxHead++;
+	}
+	if(rxWaiting)
+		__bic_SR_register_on_exit(LPM0_bits);
+}
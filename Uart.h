@@ -0,0 +1,90 @@
+/******************************************************************************
+ * Uart.h
+ *
+ * Created on: Oct 19, 2026
+ * Board: DRV2603EVM-CT RevD
+ *
+ * Desc: This file contains the USCI_A0 UART functions used for the serial
+ * 		console (9600 bps, see main.c for the UART setup).  Received bytes
+ * 		are buffered by the RX interrupt.
+ *
+ ******************************************************************************/
+
+#ifndef UART_H_
+#define UART_H_
+
+#include "msp430.h"
+#include <stdint.h>
+
+#define UART_RXBUFFERSIZE	16			// Received bytes buffered, power of two
+#define UART_NONUMBER		0xFFFF		// Uart_ReadNumber found no digits
+
+// Receive handler, called from the RX ISR for every byte (see Uart_SetReceiver)
+typedef void (*Uart_Receiver)(uint8_t data);
+
+/**
+ * printf - output a zero terminated string
+ * @param char * tx_data - string to send
+ */
+void printf(char * tx_data);
+
+/**
+ * write - output a single character
+ * @param char ch - character to send
+ */
+void write(char ch);
+
+/**
+ * getc - output a single character (legacy name)
+ * @param char c - character to send
+ */
+void getc(char c);
+
+/**
+ * Uart_PrintNumber - output an unsigned number in decimal
+ * @param uint16_t number - number to send
+ */
+void Uart_PrintNumber(uint16_t number);
+
+/**
+ * Uart_Available - number of received bytes waiting to be read
+ * @return uint8_t - bytes in the receive buffer
+ */
+uint8_t Uart_Available(void);
+
+/**
+ * Uart_Read - read a received byte without waiting
+ * @return char - the byte, 0 if nothing was received
+ */
+char Uart_Read(void);
+
+/**
+ * Uart_WaitRead - sleep in LPM0 until a byte is received and read it
+ * @return char - the byte
+ */
+char Uart_WaitRead(void);
+
+/**
+ * Uart_SetReceiver - pass received bytes to a handler in the RX ISR instead of
+ * 		the receive buffer
+ * @param Uart_Receiver receiver - handler, 0 = use the receive buffer again
+ */
+void Uart_SetReceiver(Uart_Receiver receiver);
+
+/**
+ * Uart_ReadNumber - read and echo a decimal number, leading spaces and commas
+ * 		are skipped
+ * @param char* end - set to the character that ended the number
+ * @return uint16_t - the number, UART_NONUMBER if no digits were read
+ */
+uint16_t Uart_ReadNumber(char* end);
+
+/**
+ * Uart_ReadWord - read and echo a word, leading spaces and commas are skipped
+ * @param char* word - buffer, the word is zero terminated and cut to size - 1 characters
+ * @param uint8_t size - size of the buffer
+ * @return char - the character that ended the word
+ */
+char Uart_ReadWord(char* word, uint8_t size);
+
+#endif /* UART_H_ */
@@ -0,0 +1,219 @@
+/******************************************************************************
+ * WaveformStore.c
+ *
+ * Created on: Oct 19, 2026
+ * Board: DRV2603EVM-CT RevD
+ *
+ * Desc: This file contains the waveform store, waveforms uploaded over the
+ * 		UART into reserved main flash (FLASH_WAVESTORE).  Stored waveforms
+ * 		play straight from flash.
+ *
+ * 		Both segments are append only.  An upload writes its directory entry
+ * 		first (WAVESTORE_WRITING), then the data, and marks the entry
+ * 		WAVESTORE_VALID when the CRC matches.  Replaced entries are marked
+ * 		WAVESTORE_DELETED.  Space is only reclaimed by WaveformStore_Erase.
+ *
+ ******************************************************************************/
+
+#include "WaveformStore.h"
+
+// upload in progress
+static const StoreEntry* uploadEntry;		// directory entry, 0 = no upload
+static uint8_t* uploadNext;					// next data byte to write
+static uint8_t uploadLeft;					// data bytes still expected
+
+// private functions
+static void WaveformStore_SetStatus(const StoreEntry* entry, uint8_t status);
+
+/**
+ * WaveformStore_Begin - start an upload: reserve a directory entry and space
+ * 		for the data
+ * @param uint8_t id - effect ID, 0-254
+ * @param uint8_t outputMode - waveform output mode and format flags
+ * @param uint8_t length - data size in bytes
+ * @param uint16_t crc - CRC16-CCITT of the data (WaveformStore_Crc)
+ * @param const char* name - effect name, up to WAVESTORE_NAMESIZE characters
+ * @return uint8_t - 1 if the upload started, 0 if the store is full
+ */
+uint8_t WaveformStore_Begin(uint8_t id, uint8_t outputMode, uint8_t length, uint16_t crc, const char* name)
+{
+	const StoreEntry* entry;
+	const StoreEntry* freeEntry = 0;
+	uint8_t* next = WAVESTORE_DATA;
+	uint8_t* end;
+	uint8_t i;
+
+	uploadEntry = 0;
+	if((id == WAVESTORE_NOID) || !length)
+		return 0;
+
+	// Data is appended behind every used entry, including unfinished ones
+	for(i = 0, entry = WAVESTORE_DIRECTORY; i < WAVESTORE_ENTRIES; i++, entry++)
+	{
+		if(entry->id == WAVESTORE_NOID)
+		{
+			freeEntry = entry;
+			break;
+		}
+		end = (uint8_t*) entry->waveform.data + entry->waveform.length;
+		if(end > next)
+			next = end;
+	}
+
+	if(!freeEntry || (next + length > WAVESTORE_DATA + FLASH_SEGMENTSIZE))
+		return 0;
+
+	{
+		StoreEntry newEntry = {{outputMode, length, next}, crc, id, WAVESTORE_WRITING};
+
+		for(i = 0; i < WAVESTORE_NAMESIZE; i++)
+		{
+			newEntry.name[i] = *name;
+			if(*name)
+				name++;
+		}
+		Flash_Write((uint8_t*) freeEntry, (const uint8_t*) &newEntry, sizeof(StoreEntry));
+	}
+
+	uploadEntry = freeEntry;
+	uploadNext = next;
+	uploadLeft = length;
+	return 1;
+}
+
+/**
+ * WaveformStore_Write - write the next data byte of the upload
+ * @param uint8_t data - waveform data byte
+ */
+void WaveformStore_Write(uint8_t data)
+{
+	if(!uploadEntry || !uploadLeft)
+		return;
+
+	Flash_Write(uploadNext++, &data, 1);
+	uploadLeft--;
+}
+
+/**
+ * WaveformStore_End - finish the upload
+ * @return uint8_t - 1 if the waveform was stored, 0 on a CRC or length error
+ */
+uint8_t WaveformStore_End(void)
+{
+	const StoreEntry* upload = uploadEntry;
+	const StoreEntry* entry;
+	uint8_t i;
+
+	uploadEntry = 0;
+	if(!upload || uploadLeft)
+		return 0;						// Left as WAVESTORE_WRITING, ignored
+
+	if(WaveformStore_Crc(upload->waveform.data, upload->waveform.length) != upload->crc)
+		return 0;
+
+	for(i = 0, entry = WAVESTORE_DIRECTORY; i < WAVESTORE_ENTRIES; i++, entry++)
+	{
+		if((entry != upload) && (entry->id == upload->id) && (entry->status == WAVESTORE_VALID))
+			WaveformStore_SetStatus(entry, WAVESTORE_DELETED);
+	}
+	WaveformStore_SetStatus(upload, WAVESTORE_VALID);
+
+	return 1;
+}
+
+/**
+ * WaveformStore_Find - find a stored waveform and check its CRC
+ * @param uint8_t id - effect ID
+ * @return const Waveform* - waveform in flash, 0 if not stored or corrupt
+ */
+const Waveform* WaveformStore_Find(uint8_t id)
+{
+	const StoreEntry* entry;
+	uint8_t i;
+
+	for(i = 0, entry = WAVESTORE_DIRECTORY; i < WAVESTORE_ENTRIES; i++, entry++)
+	{
+		if(entry->id == WAVESTORE_NOID)
+			break;
+		if((entry->id == id) && (entry->status == WAVESTORE_VALID))
+		{
+			if(WaveformStore_Crc(entry->waveform.data, entry->waveform.length) != entry->crc)
+				return 0;
+			return &entry->waveform;
+		}
+	}
+	return 0;
+}
+
+/**
+ * WaveformStore_Erase - erase all stored waveforms
+ */
+void WaveformStore_Erase(void)
+{
+	uploadEntry = 0;
+	Flash_EraseSegment(FLASH_WAVESTORE);
+	Flash_EraseSegment(WAVESTORE_DATA);
+}
+
+/**
+ * WaveformStore_List - print the valid entries: ID, name, mode, length and CRC
+ */
+void WaveformStore_List(void)
+{
+	const StoreEntry* entry;
+	char name[WAVESTORE_NAMESIZE + 1];
+	uint8_t i, j;
+
+	for(i = 0, entry = WAVESTORE_DIRECTORY; i < WAVESTORE_ENTRIES; i++, entry++)
+	{
+		if(entry->id == WAVESTORE_NOID)
+			break;
+		if(entry->status != WAVESTORE_VALID)
+			continue;
+
+		for(name[WAVESTORE_NAMESIZE] = 0, j = 0; j < WAVESTORE_NAMESIZE; j++)
+			name[j] = entry->name[j];
+
+		Uart_PrintNumber(entry->id);
+		printf(" ");
+		printf(name);
+		printf(" mode ");
+		Uart_PrintNumber(entry->waveform.outputMode);
+		printf(" length ");
+		Uart_PrintNumber(entry->waveform.length);
+		printf(" crc ");
+		Uart_PrintNumber(entry->crc);
+		printf("\r\n");
+	}
+}
+
+/**
+ * WaveformStore_Crc - CRC16-CCITT (polynomial 0x1021, initial value 0xFFFF)
+ * @param const uint8_t* data - data to check
+ * @param uint8_t length - size of data in bytes
+ * @return uint16_t - CRC
+ */
+uint16_t WaveformStore_Crc(const uint8_t* data, uint8_t length)
+{
+	uint16_t crc = 0xFFFF;
+	uint8_t bit;
+
+	while(length--)
+	{
+		crc ^= (uint16_t) *data++ << 8;
+		for(bit = 0; bit < 8; bit++)
+			crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+	}
+	return crc;
+}
+
+/*
+ * WaveformStore_SetStatus - program the status byte of a directory entry,
+ * 		only clears bits
+ * @param StoreEntry* entry - entry in flash
+ * @param uint8_t status - WAVESTORE_VALID or WAVESTORE_DELETED
+ */
+static void WaveformStore_SetStatus(const StoreEntry* entry, uint8_t status)
+{
+	Flash_Write((uint8_t*) &entry->status, &status, 1);
+}
@@ -0,0 +1,92 @@
+/******************************************************************************
+ * WaveformStore.h
+ *
+ * Created on: Oct 19, 2026
+ * Board: DRV2603EVM-CT RevD
+ *
+ * Desc: This file contains the waveform store, waveforms uploaded over the
+ * 		UART into reserved main flash (FLASH_WAVESTORE).  Stored waveforms
+ * 		play straight from flash.
+ *
+ ******************************************************************************/
+
+#ifndef WAVEFORMSTORE_H_
+#define WAVEFORMSTORE_H_
+
+#include "Haptics.h"
+#include "Flash.h"
+#include "Uart.h"
+
+#define WAVESTORE_NAMESIZE		8		// Name characters, not zero terminated when full
+#define WAVESTORE_NOID			0xFF	// Reserved, marks a free directory entry
+
+// Directory entry status, flash bits are only cleared until the store is erased
+#define WAVESTORE_WRITING		0xFF	// Upload not finished, ignored
+#define WAVESTORE_VALID			0x55	// Data written and CRC checked
+#define WAVESTORE_DELETED		0x00	// Replaced by a newer upload
+
+// Directory entry, the first flash segment holds the directory and the second the data
+typedef struct WaveformStore_Entry {
+	Waveform				waveform;			// mode, length and data in the data segment
+	uint16_t				crc;				// CRC16-CCITT of the data
+	uint8_t					id;					// effect ID, WAVESTORE_NOID = free entry
+	uint8_t					status;				// WAVESTORE_WRITING, _VALID or _DELETED
+	char					name[WAVESTORE_NAMESIZE];
+} StoreEntry;
+
+#define WAVESTORE_DIRECTORY		((const StoreEntry *) FLASH_WAVESTORE)
+#define WAVESTORE_ENTRIES		(FLASH_SEGMENTSIZE / sizeof(StoreEntry))
+#define WAVESTORE_DATA			(FLASH_WAVESTORE + FLASH_SEGMENTSIZE)
+
+/**
+ * WaveformStore_Begin - start an upload: reserve a directory entry and space
+ * 		for the data.  Play back must be idle (Haptics_WaitDone).
+ * @param uint8_t id - effect ID, 0-254
+ * @param uint8_t outputMode - waveform output mode and format flags
+ * @param uint8_t length - data size in bytes
+ * @param uint16_t crc - CRC16-CCITT of the data (WaveformStore_Crc)
+ * @param const char* name - effect name, up to WAVESTORE_NAMESIZE characters
+ * @return uint8_t - 1 if the upload started, 0 if the store is full
+ */
+uint8_t WaveformStore_Begin(uint8_t id, uint8_t outputMode, uint8_t length, uint16_t crc, const char* name);
+
+/**
+ * WaveformStore_Write - write the next data byte of the upload
+ * @param uint8_t data - waveform data byte
+ */
+void WaveformStore_Write(uint8_t data);
+
+/**
+ * WaveformStore_End - finish the upload.  When all data was written and the
+ * 		CRC matches the entry becomes valid and replaces older ones with the
+ * 		same ID, otherwise it is ignored.
+ * @return uint8_t - 1 if the waveform was stored, 0 on a CRC or length error
+ */
+uint8_t WaveformStore_End(void);
+
+/**
+ * WaveformStore_Find - find a stored waveform and check its CRC
+ * @param uint8_t id - effect ID
+ * @return const Waveform* - waveform in flash, 0 if not stored or corrupt
+ */
+const Waveform* WaveformStore_Find(uint8_t id);
+
+/**
+ * WaveformStore_Erase - erase all stored waveforms
+ */
+void WaveformStore_Erase(void);
+
+/**
+ * WaveformStore_List - print the valid entries: ID, name, mode, length and CRC
+ */
+void WaveformStore_List(void);
+
+/**
+ * WaveformStore_Crc - CRC16-CCITT (polynomial 0x1021, initial value 0xFFFF)
+ * @param const uint8_t* data - data to check
+ * @param uint8_t length - size of data in bytes
+ * @return uint16_t - CRC
+ */
+uint16_t WaveformStore_Crc(const uint8_t* data, uint8_t length);
+
+#endif /* WAVEFORMSTORE_H_ */
@@ -3,6 +3,11 @@
 #include "Actuator_Waveforms.h"
 #include "BinaryModes.h"
 #include "Test.h"
+#include "Uart.h"
+#include "Flash.h"
+#include "WaveformStore.h"
+#include "Drv2605.h"
+#include "LraSweep.h"
 #include <string.h>
 #include <math.h>
 
@@ -13,23 +18,28 @@
 
 /**********CONSTANTS**********/
 #define SCROLL 250
-#define BUFFERSIZE 255
+#define MCLK_HZ 8000000UL					// MCLK = SMCLK = DCO, CALBC1_8MHZ below
+#define ENVELOPEFIELDS 9		// mode + the 8 Envelope fields
 
 /**********VARIABLES**********/
-int iterator = 0;
-char buffer[BUFFERSIZE] = {0};
-int realBufferSize = 0;
-int bufferReadIndex = 0;
-int bufferWriteIndex = 0;
 char character;
 
 unsigned int i;
 
+// Envelope tuned with the 'e' command, starts as lra_pulses
+Envelope liveEnvelope = {0x02, 0x03, 0x06, 0x04, LRA_AUTOON_MAX, 0xC0, 0x03, 0x0A};
+uint8_t liveMode = LRA_AUTOON;
+
 /**********FUNCTION PROTOTYPES**********/
-void printf(char * tx_data); // Function Prototype for TX
-void write(char ch);
 void Erm_rampup(void);
-void getc(char c);
+void Envelope_Command(void);
+void Stream_Command(void);
+void Store_Command(char command);
+void Backend_Command(char command);
+void Thermal_Command(void);
+#ifdef HAPTICS_STATS
+void Stats_Command(void);
+#endif
 
 int main(void)
 {
@@ -62,6 +72,7 @@ int main(void)
 
   // Set GPIO directions
   P1DIR |= (BUTTON1+BUTTON2+BUTTON3+BUTTON4);				// Set P1.0-P1.3 to outputs for colored LEDs
+  P1DIR |= PIEZO_ENABLE;									// Set P1.4 = Output, piezo driver enable
   P2DIR |= 0x40;											// Set P2.6 = Output
   P3DIR |= (MODE0+MODE1+MODE2+MODE3+MODE4+BIT2+BIT1+BIT0);  // Set P3.0-P3.1, P3.3-P3.7 as outputs = LRA/^ERM, EN, M0-M4
 
@@ -78,77 +89,368 @@ int main(void)
   UCA0CTL1 &= ~UCSWRST;                     // **Initialize USCI state machine**
   IE2 |= UCA0RXIE;                          // Enable USCI_A0 RX interrupt
 
+  Haptics_Init();							// Finds the DCO frequency
+  Timer_Init(Haptics_smclkHz);				// TA0 time base for sleep() and the software timers
   CapTouch_Init();
-  Haptics_Init();
+  Flash_Init(MCLK_HZ);
+  LraSweep_Load();							// LRA_AUTOOFF frequency from the last sweep
   //These will engage just fine
  // CapTouch_PowerUpSequence();
-  Haptics_SendWaveform(erm_rampup);
+  Haptics_SendWaveform(&erm_rampup);
 
   for(;;)
   {
 	  __bis_SR_register(GIE);
+	  character = Uart_Read();
 	  write(character);
 	  if(character == 'a')
 	  {
 		  printf(" Successfully pressed 'a'! \r\n");
 
 		  //THIS IS WHERE THINGS BREAK
-		  //Haptics_SendWaveform(erm_rampup);
+		  //Haptics_SendWaveform(&erm_rampup);
 		  Test();
 	  }
+	  else if(character == 'c')
+	  {
+		  CapTouch_Calibrate();		// Measure and store button thresholds
+	  }
+	  else if(character == 'e')
+	  {
+		  Envelope_Command();		// Set and play the live envelope
+	  }
+	  else if(character == 's')
+	  {
+		  Stream_Command();			// Play samples sent by the host
+	  }
+	  else if((character == 'w') || (character == 'l') || (character == 'p') || (character == 'x'))
+	  {
+		  Store_Command(character);	// Upload, list, play or erase stored waveforms
+	  }
+	  else if(character == 'r')
+	  {
+		  LraSweep_Run();			// Find the LRA resonance from rated bursts
+	  }
+	  else if((character == 'i') || (character == 'g'))
+	  {
+		  Backend_Command(character);	// Select the I2C driver, play library effects
+	  }
+	  else if(character == 't')
+	  {
+		  Thermal_Command();		// Show the actuator energy model, set its budget
+	  }
+#ifdef HAPTICS_STATS
+	  else if(character == 'v')
+	  {
+		  Stats_Command();			// Dump and clear the playback statistics
+	  }
+#endif
 	  character = 0x00;
 	  //This works just fine
-	  //Haptics_SendWaveform(erm_rampup);
+	  //Haptics_SendWaveform(&erm_rampup);
   }
 }
 
 void Erm_rampup(void)
 {
-	Haptics_SendWaveform(erm_rampup);
+	Haptics_SendWaveform(&erm_rampup);
 }
 
-// Output char to UART
-void getc(char c)
+/**
+ * Envelope_Command - "e mode attack decay sustain release peak level repeat gap"
+ * 		sets the live envelope and plays it, "e" alone plays it again.
+ * 		mode: 0 = LRA_AUTOON, 1 = LRA_AUTOOFF, 2 = ERM, 3 = PIEZO.  Prints the envelope.
+ */
+void Envelope_Command(void)
 {
-	while((UCA0STAT & UCBUSY));
+	uint8_t values[ENVELOPEFIELDS];
+	uint8_t count = 0;
+	uint16_t value;
+	char end = 0;
+
+	while(count < ENVELOPEFIELDS)
+	{
+		value = Uart_ReadNumber(&end);
+		if(value == UART_NONUMBER)
+			break;
+		values[count++] = (uint8_t) value;
+		if((end == '\r') || (end == '\n'))
+			break;
+	}
+
+	if(count == ENVELOPEFIELDS && values[0] < HAPTICS_MODES)
 	{
-	UCA0RXBUF = c;
+		liveMode = values[0];
+		liveEnvelope.attack = values[1];
+		liveEnvelope.decay = values[2];
+		liveEnvelope.sustain = values[3];
+		liveEnvelope.release = values[4];
+		liveEnvelope.peak = values[5];
+		liveEnvelope.level = values[6];
+		liveEnvelope.repeat = values[7];
+		liveEnvelope.gap = values[8];
+	}
+	else if(count)
+	{
+		printf("\r\nUsage: e mode attack decay sustain release peak level repeat gap\r\n");
+		return;
+	}
+
+	printf("\r\nEnvelope ");
+	Uart_PrintNumber(liveMode);
+	printf(" ");
+	Uart_PrintNumber(liveEnvelope.attack);
+	printf(" ");
+	Uart_PrintNumber(liveEnvelope.decay);
+	printf(" ");
+	Uart_PrintNumber(liveEnvelope.sustain);
+	printf(" ");
+	Uart_PrintNumber(liveEnvelope.release);
+	printf(" ");
+	Uart_PrintNumber(liveEnvelope.peak);
+	printf(" ");
+	Uart_PrintNumber(liveEnvelope.level);
+	printf(" ");
+	Uart_PrintNumber(liveEnvelope.repeat);
+	printf(" ");
+	Uart_PrintNumber(liveEnvelope.gap);
+	printf("\r\n");
+
+	{
+		const Waveform live = {liveMode + HAPTICS_ENVELOPE, sizeof(Envelope), (const unsigned char*) &liveEnvelope};
+		Haptics_SendWaveform(&live);
 	}
 }
-#pragma vector=USCIAB0RX_VECTOR
-__interrupt void USCI0RX_ISR(void)
+
+/**
+ * Stream_Command - "s mode periods" plays the following bytes as PWM samples,
+ * 		one every periods * 256 SMCLK cycles, 32us at 8MHz (default LRA_AUTOON,
+ * 		HAPTICS_STREAMPERIODS).
+ * 		Send the samples after "Streaming" is printed, the stream ends when
+ * 		no data arrives for HAPTICS_STREAMTIMEOUT samples.  Prints the counters.
+ */
+void Stream_Command(void)
 {
-	character = UCA0RXBUF;
+	uint16_t mode = LRA_AUTOON;
+	uint16_t periods = HAPTICS_STREAMPERIODS;
+	uint16_t value;
+	char end = 0;
+
+	value = Uart_ReadNumber(&end);
+	if(value != UART_NONUMBER)
+	{
+		mode = value;
+		if((end != '\r') && (end != '\n'))
+		{
+			value = Uart_ReadNumber(&end);
+			if(value != UART_NONUMBER)
+				periods = value;
+		}
+	}
+
+	if((mode >= HAPTICS_MODES) || !periods || (periods > 255))
+	{
+		printf("\r\nUsage: s mode periods\r\n");
+		return;
+	}
+
+	if(!Haptics_StreamStart(mode, periods))
+	{
+		printf((Haptics_GetThermalState() == HAPTICS_THERMAL_REFUSING) ? "\r\nActuator cooling down\r\n"
+				: "\r\nOutput disabled\r\n");
+		return;
+	}
+
+	Uart_SetReceiver(Haptics_StreamByte);		// Samples go straight to the player
+	printf("\r\nStreaming\r\n");
+	Haptics_WaitDone();
+	Uart_SetReceiver(0);
+
+	printf("Samples ");
+	Uart_PrintNumber(Haptics_streamSamples);
+	printf(" underruns ");
+	Uart_PrintNumber(Haptics_streamUnderruns);
+	printf(" overruns ");
+	Uart_PrintNumber(Haptics_streamOverruns);
+	printf("\r\n");
 }
-void write(char ch)
+
+/**
+ * Store_Command - waveform store commands
+ * 		"w id mode length crc name" upload a waveform as effect id
+ * 		(EFFECT_USER-254).  Send the data "b0 b1 ..." in decimal on the next
+ * 		line after "Ready" is printed, the directory entry is written first
+ * 		and the CPU stalls for it (see tools/haptics_upload.py).
+ * 		"l" list the stored waveforms
+ * 		"p id" play an effect, built in (EFFECT_*) or stored
+ * 		"x" erase all stored waveforms
+ * @param char command - 'w', 'l', 'p' or 'x'
+ */
+void Store_Command(char command)
 {
-	while ((UCA0STAT & UCBUSY));
+	uint16_t header[4];						// id, mode, length, crc
+	char name[WAVESTORE_NAMESIZE + 1];
+	uint16_t value;
+	char end = 0;
+	uint8_t i;
+
+	printf("\r\n");
+	switch(command)
 	{
-				UCA0TXBUF  = ch;
+	case 'w':
+		for(i = 0; i < 4; i++)
+		{
+			header[i] = Uart_ReadNumber(&end);
+			if((header[i] == UART_NONUMBER) || (end == '\r') || (end == '\n'))
+				break;
+		}
+		if(i == 4)
+			end = Uart_ReadWord(name, sizeof(name));
+		if((i < 4) || ((end != '\r') && (end != '\n')) || (header[0] < EFFECT_USER) || (header[0] >= WAVESTORE_NOID)
+				|| (header[1] > 0xFF) || !header[2] || (header[2] > 0xFF))
+		{
+			printf("\r\nUsage: w id mode length crc name, then the data after Ready\r\n");
+			break;
+		}
+
+		Haptics_WaitDone();					// The CPU stalls while flash is written
+		if(!WaveformStore_Begin(header[0], header[1], header[2], header[3], name))
+		{
+			printf("\r\nStore full\r\n");
+			break;
+		}
+		printf("\r\nReady\r\n");				// The host sends the data now
+		end = 0;
+		for(i = 0; (i < header[2]) && (end != '\r') && (end != '\n'); i++)
+		{
+			value = Uart_ReadNumber(&end);
+			if(value == UART_NONUMBER)
+				break;
+			WaveformStore_Write((uint8_t) value);
+		}
+		printf(WaveformStore_End() ? "\r\nStored\r\n" : "\r\nUpload failed\r\n");
+		break;
+	case 'l':
+		WaveformStore_List();
+		break;
+	case 'p':
+		value = Uart_ReadNumber(&end);
+		if((value >= WAVESTORE_NOID) || !Haptics_SendEffect(value))
+			printf("\r\nNot found\r\n");
+		break;
+	case 'x':
+		Haptics_WaitDone();
+		WaveformStore_Erase();
+		printf("Store erased\r\n");
+		break;
 	}
 }
-void printf(char * tx_data)
+
+/**
+ * Backend_Command - output backend commands
+ * 		"i" switch between the DRV2603 PWM and the DRV2605 I2C backend
+ * 		"g mode effect" play a DRV2605 library effect
+ * @param char command - 'i' or 'g'
+ */
+void Backend_Command(char command)
 {
-    unsigned int i=0;
-    while(tx_data[i])
-    {
-        while ((UCA0STAT & UCBUSY));
-        UCA0TXBUF = tx_data[i];
-        i++;
-    }
+	uint16_t mode;
+	uint16_t effect = UART_NONUMBER;
+	char end = 0;
+
+	printf("\r\n");
+	if(command == 'i')
+	{
+		if(Haptics_GetBackend() == &Drv2605_backend)
+		{
+			Haptics_SetBackend(&Haptics_pwmBackend);
+			printf("PWM backend\r\n");
+		}
+		else if(Drv2605_Init())
+		{
+			Haptics_SetBackend(&Drv2605_backend);
+			printf("DRV2605 backend\r\n");
+		}
+		else
+			printf("DRV2605 not found\r\n");
+		return;
+	}
+
+	mode = Uart_ReadNumber(&end);
+	if((mode != UART_NONUMBER) && (end != '\r') && (end != '\n'))
+		effect = Uart_ReadNumber(&end);
+	if((mode >= HAPTICS_MODES) || (effect == UART_NONUMBER) || (effect > 0xFF))
+	{
+		printf("\r\nUsage: g mode effect\r\n");
+		return;
+	}
+	if(!Haptics_PlayLibraryEffect(mode, effect))
+		printf("\r\nNo library effect\r\n");
 }
-#pragma vector=TIMER0_A0_VECTOR
-__interrupt void ISR_Timer0_A0(void)
+
+/**
+ * Thermal_Command - "t [drive]" sets the thermal budget if a drive (0-128,
+ * 		0 = no limit) is given, then prints the energy in percent of the
+ * 		budget and the state
+ */
+void Thermal_Command(void)
 {
-  TA0CTL &= ~(MC_1);
-  TA0CCTL0 &= ~(CCIE);
+	static const char* const states[] = {" ok\r\n", " throttled\r\n", " refusing\r\n"};
+	uint16_t drive;
+	char end = 0;
 
-  CapTouch_RandomNumber++;
+	drive = Uart_ReadNumber(&end);
+	if(drive != UART_NONUMBER)
+	{
+		if(drive > 128)
+		{
+			printf("\r\nUsage: t [drive 0-128]\r\n");
+			return;
+		}
+		Haptics_SetThermalBudget(drive);
+	}
 
-  __bic_SR_register_on_exit(LPM0_bits+GIE);
+	printf("\r\nThermal ");
+	Uart_PrintNumber(Haptics_GetThermalLoad());
+	printf("%");
+	printf((char*) states[Haptics_GetThermalState()]);
 }
-#pragma vector=TIMER1_A1_VECTOR
-__interrupt void Timer_A1_ISR (void)
+
+#ifdef HAPTICS_STATS
+/**
+ * Stats_Command - "v" prints the playback statistics and clears them, one line
+ * 		per effect ID (255 = no ID):
+ * 		"id plays latency_us max_latency_us duration_ms error_us late_steps"
+ */
+void Stats_Command(void)
 {
-  TA1CCTL1 &= ~CCIFG;   //Clear Interrupt Flag
+	PlayStats stats;
+	uint8_t i;
+
+	printf("\r\nid plays latency max duration error late\r\n");
+	for(i = 0; i < HAPTICS_STATSSIZE; i++)
+	{
+		__bic_SR_register(GIE);
+		stats = Haptics_stats[i];			// The player updates records in its ISR
+		__bis_SR_register(GIE);
+		if(!stats.plays)
+			continue;
+
+		Uart_PrintNumber(stats.id);
+		printf(" ");
+		Uart_PrintNumber(stats.plays);
+		printf(" ");
+		Uart_PrintNumber(stats.latency);
+		printf(" ");
+		Uart_PrintNumber(stats.latencyMax);
+		printf(" ");
+		Uart_PrintNumber(stats.duration);
+		printf((stats.error < 0) ? " -" : " ");
+		Uart_PrintNumber((stats.error < 0) ? -stats.error : stats.error);
+		printf(" ");
+		Uart_PrintNumber(stats.late);
+		printf("\r\n");
+	}
+	Haptics_StatsClear();
 }
+#endif
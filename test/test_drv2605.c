@@ -0,0 +1,137 @@
+/******************************************************************************
+ * test_drv2605.c
+ *
+ * Created on: Oct 19, 2026
+ * Board: DRV2603EVM-CT RevD
+ *
+ * Desc: Host test of the DRV2605 backend against the simulated I2C target
+ * 		(I2C_SIMULATION, see I2c.h).  Build and run with make in this
+ * 		directory.
+ *
+ ******************************************************************************/
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "../Drv2605.h"
+
+// Haptics.c is not part of the host build, these are the values it sets up
+uint16_t Haptics_dumbModeTick = LRAFREQ_185;
+uint32_t Haptics_smclkHz = HAPTICS_SMCLK_DEFAULT;
+
+/*
+ * Test_Reset - a DRV2605 at its address with the power on register values
+ * @param uint8_t deviceId - DEVICE_ID in the status register
+ */
+static void Test_Reset(uint8_t deviceId)
+{
+	memset(I2c_simRegisters, 0, sizeof(I2c_simRegisters));
+	I2c_simAddress = DRV2605_ADDRESS;
+	I2c_simRegisters[DRV2605_STATUS] = deviceId << 5;
+	I2c_simRegisters[DRV2605_MODE] = DRV2605_MODE_STANDBY;
+	I2c_simRegisters[DRV2605_FEEDBACK] = 0x36;			// ERM, the reset value
+	I2c_simRegisters[DRV2605_CONTROL3] = 0xA0 | DRV2605_DATA_UNSIGNED;
+	I2c_simWrites = 0;
+}
+
+static void Test_Init(void)
+{
+	Test_Reset(DRV2605_DEVICEID_2605L);
+	assert(Drv2605_Init());
+	assert(I2c_simRegisters[DRV2605_MODE] == DRV2605_MODE_STANDBY);
+	assert(!(I2c_simRegisters[DRV2605_CONTROL3] & DRV2605_DATA_UNSIGNED));
+	assert((I2c_simRegisters[DRV2605_CONTROL3] & ~DRV2605_DATA_UNSIGNED) == 0xA0);
+
+	Test_Reset(DRV2605_DEVICEID_2605);
+	assert(Drv2605_Init());
+
+	Test_Reset(4);											// DRV2604, no library
+	assert(!Drv2605_Init());
+	assert(!I2c_simWrites);
+
+	Test_Reset(DRV2605_DEVICEID_2605L);
+	I2c_simAddress = DRV2605_ADDRESS + 1;					// Nothing answers
+	assert(!Drv2605_Init());
+	assert(!I2c_simWrites);
+}
+
+static void Test_Mode(void)
+{
+	Test_Reset(DRV2605_DEVICEID_2605L);
+	assert(Drv2605_Init());
+
+	Drv2605_backend.mode(ERM);
+	assert(!(I2c_simRegisters[DRV2605_FEEDBACK] & DRV2605_N_ERM_LRA));
+	assert(I2c_simRegisters[DRV2605_LIBRARY] == DRV2605_LIBRARY_ERM);
+
+	Drv2605_backend.mode(LRA_AUTOON);
+	assert(I2c_simRegisters[DRV2605_FEEDBACK] == (0x36 | DRV2605_N_ERM_LRA));
+	assert(!(I2c_simRegisters[DRV2605_CONTROL3] & DRV2605_LRA_OPEN_LOOP));
+	assert(I2c_simRegisters[DRV2605_LIBRARY] == DRV2605_LIBRARY_LRA);
+
+	Drv2605_backend.mode(LRA_AUTOOFF);
+	assert(I2c_simRegisters[DRV2605_CONTROL3] & DRV2605_LRA_OPEN_LOOP);
+	assert(I2c_simRegisters[DRV2605_OLPERIOD] == 55);		// 185Hz = 5405us = 55 x 98.46us
+	assert(I2c_simRegisters[DRV2605_LIBRARY] == DRV2605_LIBRARY_LRA);
+	assert(!Drv2605_backend.carrier);
+	assert(!Drv2605_backend.isrMode);						// Several blocking transfers
+}
+
+static void Test_Output(void)
+{
+	uint16_t writes;
+
+	Test_Reset(DRV2605_DEVICEID_2605L);
+	assert(Drv2605_Init());
+	Drv2605_backend.mode(LRA_AUTOON);
+
+	Drv2605_backend.start();
+	assert(I2c_simRegisters[DRV2605_MODE] == DRV2605_MODE_RTP);
+	assert(I2c_simRegisters[DRV2605_RTP] == 0);
+
+	Drv2605_backend.output(0xFF, 1);						// Full drive
+	assert(I2c_simRegisters[DRV2605_RTP] == 0x7F);
+	writes = I2c_simWrites;
+	Drv2605_backend.output(0xFF, 1);						// Unchanged, not written again
+	assert(I2c_simWrites == writes);
+
+	Drv2605_backend.output(0x00, 1);						// Full brake
+	assert(I2c_simRegisters[DRV2605_RTP] == 0x80);
+	Drv2605_backend.output(0xC0, 0);						// No drive
+	assert(I2c_simRegisters[DRV2605_RTP] == 0);
+
+	Drv2605_backend.output(0xC0, 1);
+	Drv2605_backend.stop();
+	assert(I2c_simRegisters[DRV2605_RTP] == 0);
+	assert(I2c_simRegisters[DRV2605_MODE] == DRV2605_MODE_STANDBY);
+}
+
+static void Test_Effect(void)
+{
+	Test_Reset(DRV2605_DEVICEID_2605L);
+	assert(Drv2605_Init());
+	Drv2605_backend.mode(ERM);
+
+	assert(!Drv2605_backend.effect(0));
+	assert(!Drv2605_backend.effect(DRV2605_EFFECTS + 1));
+	assert(I2c_simRegisters[DRV2605_GO] == 0);
+
+	assert(Drv2605_backend.effect(47));
+	assert(I2c_simRegisters[DRV2605_MODE] == DRV2605_MODE_INTERNAL);
+	assert(I2c_simRegisters[DRV2605_WAVESEQ1] == 47);
+	assert(I2c_simRegisters[DRV2605_WAVESEQ2] == 0);
+	assert(I2c_simRegisters[DRV2605_GO] == 1);
+
+	I2c_simAddress = 0;										// Driver gone
+	assert(!Drv2605_backend.effect(47));
+}
+
+int main(void)
+{
+	Test_Init();
+	Test_Mode();
+	Test_Output();
+	Test_Effect();
+	printf("test_drv2605: passed\n");
+	return 0;
+}
@@ -0,0 +1,438 @@
+#!/usr/bin/env python3
+"""
+haptics_prep.py - build the Actuator_Waveforms.c tables from effect
+descriptions, synthesizing overdrive and active braking.
+
+Created on: Oct 19, 2026
+Board: DRV2603EVM-CT RevD
+
+Every effect names an actuator, which sets the output mode and the level
+limits, and is written in one of two ways.
+
+An "envelope" is a target intensity envelope, a list of
+[intensity, duration_ms] steps with intensity 0.0-1.0.  The actuator is
+modelled as a first order system:
+
+    ERM         motor speed follows the drive with time constant tau_ms
+    LRA         the vibration envelope follows the drive with
+                tau = Q / (pi * f0)
+
+For every step the generator drives at full amplitude (overdrive) until the
+modelled intensity reaches the target, or at full reverse (brake) until it
+falls to the target, then holds the drive that keeps the target.  After the
+last step the actuator is braked to rest and the amplifier released (0x80).
+The comment of the table gives the modelled rise and stop times of the
+plain and the synthesized waveform.
+
+"steps" are played as written, times in ms:
+
+    ["hold", level, ms]             output level for ms
+    ["ramp", level, ms]             move linearly to level over ms
+    ["loop", count, [steps]]        play the steps count (1-127) times
+
+A level is a byte or a "0x.." string, "MAX" (max_level), "OFF" (0x80) or
+"BRAKE" (min_level).  Ramps and loops use the HAPTICS_SEGMENTS escapes, the
+flag is added when an effect needs it.  Holds longer than 255 ticks are split.
+
+Every effect is checked: levels within the actuator limits, no step shorter
+than a tick, at most 255 data bytes (the Waveform length is a byte), the
+duration within max_ms and the flash use of all effects within
+flash_budget.  A report goes to stderr and the tables to stdout or -o.  With
+--update the tables of the same name in a C file are replaced in place, so
+the firmware effects are regenerated rather than pasted; effects the file
+does not have yet are printed.
+
+Usage:
+    python3 tools/haptics_prep.py tools/haptics_effects.json
+    python3 tools/haptics_prep.py tools/haptics_effects.json -o effects.c
+    python3 tools/haptics_prep.py tools/haptics_effects.json --update Actuator_Waveforms.c
+
+DRV2603 PWM input: 0x80 is no drive, 0xFF full drive, 0x00 full reverse
+(brake).  max_level limits the forward drive (e.g. LRA_AUTOON_MAX),
+min_level the reverse drive (e.g. 0x1A for the 2 Vrms LRA_AUTOOFF drive).
+"""
+
+import argparse
+import json
+import math
+import re
+import sys
+
+MODES = ("LRA_AUTOON", "LRA_AUTOOFF", "ERM", "PIEZO")
+IDLE = 0x80
+LEVELS = {"OFF": IDLE}
+MAX_TICKS = 255                 # time field of one pair, ramp ticks
+MAX_BYTES = 255                 # Waveform length
+MAX_LOOP = 127                  # HAPTICS_LOOP count
+WAVEFORM_BYTES = 4              # sizeof(Waveform): mode, length, 16 bit pointer
+
+# Intensity thresholds used for the reported rise and stop times
+RISE_LEVEL = 0.9
+STOP_LEVEL = 0.1
+
+
+class PrepError(Exception):
+    pass
+
+
+class Actuator:
+    def __init__(self, name, spec):
+        self.name = name
+        self.mode = spec["mode"]
+        if self.mode not in MODES:
+            raise PrepError("actuator '%s': unknown mode %s" % (name, self.mode))
+        if "tau_ms" in spec:
+            self.tau_ms = float(spec["tau_ms"])
+        elif "f0_hz" in spec and "q" in spec:
+            self.tau_ms = 1000.0 * float(spec["q"]) / (math.pi * float(spec["f0_hz"]))
+        else:
+            raise PrepError("actuator '%s': needs tau_ms, or f0_hz and q" % name)
+        if self.tau_ms <= 0:
+            raise PrepError("actuator '%s': time constant must be > 0" % name)
+        self.max_level = int(spec.get("max_level", 0xFF))
+        if not IDLE < self.max_level <= 0xFF:
+            raise PrepError("actuator '%s': max_level must be 0x81-0xFF" % name)
+        self.max_level_name = spec.get("max_level_name")
+        self.min_level = int(spec.get("min_level", 0x00))
+        if not 0x00 <= self.min_level < IDLE:
+            raise PrepError("actuator '%s': min_level must be 0x00-0x7F" % name)
+        self.brake = bool(spec.get("brake", True))
+
+    def level(self, drive):
+        """DRV2603 duty cycle for a normalized drive, -1.0 (brake) to 1.0."""
+        if drive >= 0:
+            return IDLE + int(round(drive * (self.max_level - IDLE)))
+        return IDLE + int(round(drive * (IDLE - self.min_level)))
+
+    def drive(self, level):
+        if level >= IDLE:
+            return (level - IDLE) / float(self.max_level - IDLE)
+        return (level - IDLE) / float(IDLE - self.min_level)
+
+    def level_text(self, level):
+        if level == self.max_level and self.max_level_name:
+            return self.max_level_name
+        return "0x%02X" % level
+
+    def parse_level(self, value):
+        """Level of a step: a byte, "0x..", "MAX", "OFF" or "BRAKE"."""
+        if value == "MAX":
+            return self.max_level
+        if value == "BRAKE":
+            return self.min_level
+        if value in LEVELS:
+            return LEVELS[value]
+        try:
+            level = value if isinstance(value, int) else int(value, 0)
+        except (TypeError, ValueError):
+            raise PrepError("bad level %r" % (value,))
+        if not self.min_level <= level <= self.max_level:
+            raise PrepError("level 0x%02X outside 0x%02X-0x%02X of actuator '%s'"
+                            % (level, self.min_level, self.max_level, self.name))
+        return level
+
+
+def settle_time(x0, target, drive, tau):
+    """Time for x' = (drive - x) / tau to go from x0 to target."""
+    if (drive - x0) == 0 or (drive - target) == 0:
+        return float("inf")
+    ratio = (drive - x0) / (drive - target)
+    if ratio <= 0:
+        return float("inf")
+    return tau * math.log(ratio)
+
+
+def simulate(actuator, pairs, tick_ms, dt_ms=0.1):
+    """Modelled intensity samples for (level, ticks) pairs, then idle."""
+    x = 0.0
+    trace = []
+    t = 0.0
+    for level, ticks in pairs + [(IDLE, 60)]:
+        drive = actuator.drive(level)
+        end = t + ticks * tick_ms
+        while t < end:
+            x += (drive - x) * dt_ms / actuator.tau_ms
+            if x < 0 and drive <= 0:
+                x = 0.0             # braking stops the actuator, it does not reverse
+            trace.append((t, x))
+            t += dt_ms
+    return trace
+
+
+def response_times(trace, peak_target):
+    rise = stop = None
+    peak_time = None
+    for t, x in trace:
+        if rise is None and x >= RISE_LEVEL * peak_target:
+            rise = t
+        if x >= STOP_LEVEL * peak_target:
+            peak_time = t
+    if peak_time is not None:
+        stop = peak_time
+    return rise, stop
+
+
+def to_ticks(ms, tick_ms):
+    return int(round(ms / tick_ms))
+
+
+def append(pairs, level, ticks):
+    while ticks > 0:
+        n = min(ticks, MAX_TICKS)
+        if pairs and pairs[-1][0] == level and pairs[-1][1] + n <= MAX_TICKS:
+            pairs[-1] = (level, pairs[-1][1] + n)
+        else:
+            pairs.append((level, n))
+        ticks -= n
+
+
+def plain(actuator, envelope, tick_ms):
+    """The envelope played as is, without overdrive or braking."""
+    pairs = []
+    for intensity, duration in envelope:
+        append(pairs, actuator.level(intensity), to_ticks(duration, tick_ms))
+    append(pairs, IDLE, 1)
+    return pairs
+
+
+def synthesize(actuator, envelope, tick_ms):
+    tau = actuator.tau_ms
+    full = 1.0
+    reverse = -1.0 if actuator.brake else 0.0
+    pairs = []
+    x = 0.0
+    for intensity, duration in envelope + [(0.0, None)]:
+        if not 0.0 <= intensity <= 1.0:
+            raise PrepError("intensity %.2f out of range 0.0-1.0" % intensity)
+        step_ticks = None if duration is None else max(1, to_ticks(duration, tick_ms))
+
+        if intensity > x:
+            kick_ms = settle_time(x, intensity, full, tau) if intensity < full else float("inf")
+            kick = to_ticks(kick_ms, tick_ms) if kick_ms != float("inf") else step_ticks
+        elif intensity < x:
+            kick_ms = settle_time(x, intensity, reverse, tau)
+            kick = to_ticks(kick_ms, tick_ms) if kick_ms != float("inf") else 0
+        else:
+            kick = 0
+
+        if step_ticks is not None:
+            kick = min(kick, step_ticks)
+        if kick:
+            append(pairs, actuator.level(full if intensity > x else reverse), kick)
+
+        # state after the kick, then hold the target drive
+        drive = full if intensity > x else reverse
+        x = drive + (x - drive) * math.exp(-kick * tick_ms / tau) if kick else x
+        if step_ticks is not None:
+            hold = step_ticks - kick
+            if hold > 0:
+                append(pairs, actuator.level(intensity), hold)
+                x = intensity + (x - intensity) * math.exp(-hold * tick_ms / tau)
+
+    append(pairs, IDLE, 1)
+    return pairs
+
+
+class Table:
+    """The data rows of one effect and what they cost."""
+
+    def __init__(self):
+        self.rows = []
+        self.bytes = 0
+        self.ticks = 0
+        self.peak = IDLE
+        self.segments = False
+
+    def pair(self, actuator, level, ticks):
+        self.rows.append("%s, 0x%02X" % (actuator.level_text(level), ticks))
+        self.bytes += 2
+        self.ticks += ticks
+        self.peak = max(self.peak, level)
+
+
+def envelope_table(actuator, pairs):
+    table = Table()
+    for level, ticks in pairs:
+        table.pair(actuator, level, ticks)
+    return table
+
+
+def step_ticks(ms, tick_ms):
+    ticks = to_ticks(float(ms), tick_ms)
+    if ticks < 1:
+        raise PrepError("%s ms is shorter than a tick (%.3f ms)" % (ms, tick_ms))
+    return ticks
+
+
+def compile_steps(actuator, steps, tick_ms, table, nested=False):
+    """Append the rows of hold/ramp/loop steps to table."""
+    for step in steps:
+        kind = step[0]
+        if kind == "hold":
+            level = actuator.parse_level(step[1])
+            ticks = step_ticks(step[2], tick_ms)
+            while ticks > 0:
+                n = min(ticks, MAX_TICKS)
+                table.pair(actuator, level, n)
+                ticks -= n
+        elif kind == "ramp":
+            level = actuator.parse_level(step[1])
+            ticks = step_ticks(step[2], tick_ms)
+            if ticks > MAX_TICKS:
+                raise PrepError("ramp of %d ticks, split it (at most %d)" % (ticks, MAX_TICKS))
+            table.rows.append("%s, 0x00, 0x%02X" % (actuator.level_text(level), ticks))
+            table.bytes += 3
+            table.ticks += ticks
+            table.peak = max(table.peak, level)
+            table.segments = True
+        elif kind == "loop":
+            if nested:
+                raise PrepError("loops do not nest")
+            count = int(step[1])
+            if not 1 <= count <= MAX_LOOP:
+                raise PrepError("loop count %d out of range 1-%d" % (count, MAX_LOOP))
+            body = Table()
+            compile_steps(actuator, step[2], tick_ms, body, nested=True)
+            if body.bytes > MAX_BYTES:
+                raise PrepError("loop body of %d bytes" % body.bytes)
+            table.rows.append("HAPTICS_LOOP(%d, %d)" % (count, body.bytes))
+            table.rows.extend(body.rows)
+            table.bytes += 4 + body.bytes
+            table.ticks += count * body.ticks
+            table.peak = max(table.peak, body.peak)
+            table.segments = True
+        else:
+            raise PrepError("unknown step %r" % (kind,))
+    return table
+
+
+def c_waveform(name, actuator, table, comment):
+    mode = actuator.mode + ("+HAPTICS_SEGMENTS" if table.segments else "")
+    out = []
+    out.append("// %s" % comment)
+    out.append("const unsigned char %s_data[] = {" % name)
+    out.append(",\n".join("\t\t" + row for row in table.rows) + "};")
+    out.append("const Waveform %s = {%s,sizeof(%s_data),%s_data};" % (name, mode, name, name))
+    return "\n".join(out)
+
+
+def update(path, blocks):
+    """Replace the tables of the generated effects in a C file, returns the
+    blocks of the effects it does not have."""
+    with open(path) as f:
+        text = f.read()
+    missing = []
+    for name, actuator, block in blocks:
+        pattern = re.compile(r"(?:// %s, [^\n]*\n)?const unsigned char %s_data\[\] = \{.*?\};\n"
+                             r"const Waveform %s = \{[^\n]*\};" % (re.escape(actuator.name), name, name), re.S)
+        text, count = pattern.subn(lambda m: block, text)
+        if count > 1:
+            raise PrepError("%s: %d tables named %s" % (path, count, name))
+        if not count:
+            missing.append((name, actuator, block))
+    with open(path, "w") as f:
+        f.write(text)
+    return missing
+
+
+def ms(value):
+    return "never" if value is None else "%.0f ms" % value
+
+
+def prepare(actuator, effect, tick_ms):
+    """The table and comment of one effect."""
+    if "steps" in effect:
+        table = compile_steps(actuator, effect["steps"], tick_ms, Table())
+        if not table.rows:
+            raise PrepError("no steps")
+        comment = "%s, steps: %s, peak 0x%02X" % (actuator.name, ms(table.ticks * tick_ms), table.peak)
+        return table, comment
+
+    envelope = [(float(i), float(d)) for i, d in effect["envelope"]]
+    if not envelope:
+        raise PrepError("empty envelope")
+    peak = max(i for i, _ in envelope)
+
+    naive = plain(actuator, envelope, tick_ms)
+    shaped = synthesize(actuator, envelope, tick_ms)
+    naive_rise, naive_stop = response_times(simulate(actuator, naive, tick_ms), peak)
+    rise, stop = response_times(simulate(actuator, shaped, tick_ms), peak)
+    comment = ("%s, tau %.1f ms: rise %s (plain %s), stop %s (plain %s)"
+               % (actuator.name, actuator.tau_ms, ms(rise), ms(naive_rise),
+                  ms(stop), ms(naive_stop)))
+    return envelope_table(actuator, shaped), comment
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("spec", help="actuators and effects (JSON)")
+    parser.add_argument("-o", "--output", help="write the C waveforms to this file")
+    parser.add_argument("--update", help="replace the tables of the same name in this C file")
+    args = parser.parse_args()
+
+    with open(args.spec) as f:
+        spec = json.load(f)
+
+    errors = 0
+    blocks = []
+    total = 0
+    try:
+        tick_ms = float(spec["tick_ms"])
+        max_ms = spec.get("max_ms")
+        actuators = {name: Actuator(name, a) for name, a in spec["actuators"].items()}
+    except (PrepError, KeyError, ValueError) as err:
+        print("%s: %s" % (args.spec, err), file=sys.stderr)
+        return 2
+
+    for effect in spec["effects"]:
+        name = effect.get("name", "?")
+        try:
+            if effect["actuator"] not in actuators:
+                raise PrepError("unknown actuator %s" % effect["actuator"])
+            actuator = actuators[effect["actuator"]]
+            table, comment = prepare(actuator, effect, tick_ms)
+            if table.bytes > MAX_BYTES:
+                raise PrepError("%d data bytes, a Waveform holds %d" % (table.bytes, MAX_BYTES))
+            limit = effect.get("max_ms", max_ms)
+            if limit is not None and table.ticks * tick_ms > limit:
+                raise PrepError("%.0f ms, longer than max_ms %d" % (table.ticks * tick_ms, limit))
+        except (PrepError, KeyError, IndexError, TypeError, ValueError) as err:
+            print("%s: %s: %s" % (args.spec, name, err), file=sys.stderr)
+            errors += 1
+            continue
+        flash = table.bytes + WAVEFORM_BYTES
+        total += flash
+        print("%-28s %s, %d bytes of flash" % (name, comment, flash), file=sys.stderr)
+        blocks.append((name, actuator, c_waveform(name, actuator, table, comment)))
+
+    print("%-28s %d bytes of flash" % ("total", total), file=sys.stderr)
+    budget = spec.get("flash_budget")
+    if budget is not None and total > budget:
+        print("%s: %d bytes of flash, over flash_budget %d" % (args.spec, total, budget), file=sys.stderr)
+        errors += 1
+    if errors:
+        return 2
+
+    if args.update:
+        try:
+            blocks = update(args.update, blocks)
+        except (PrepError, OSError) as err:
+            print("%s: %s" % (args.spec, err), file=sys.stderr)
+            return 2
+        if not blocks:
+            return 0
+        print("%s: not in %s, add them from the output" % (", ".join(name for name, _, _ in blocks), args.update),
+              file=sys.stderr)
+
+    text = ("// Generated by tools/haptics_prep.py from tools/%s\n\n" % args.spec.split("/")[-1]
+            + "\n\n".join(block for _, _, block in blocks) + "\n")
+    if args.output:
+        with open(args.output, "w") as f:
+            f.write(text)
+    else:
+        sys.stdout.write(text)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+"""
+haptics_upload.py - upload a waveform into the waveform store (see
+WaveformStore.c and the 'w' command in main.c).
+
+Created on: Oct 19, 2026
+Board: DRV2603EVM-CT RevD
+
+The upload is two lines:
+    w id mode length crc name
+    b0 b1 ...
+with the CRC16-CCITT (polynomial 0x1021, initial value 0xFFFF) of the data.
+The board writes the directory entry to flash after the first line, the CPU
+stalls and would miss UART bytes, so the data is only sent once the board
+prints "Ready".  The tool then waits for "Stored" or "Upload failed".
+
+Usage:
+    python3 tools/haptics_upload.py /dev/ttyACM0 0x80 LRA_AUTOON click 0xF0 5 0x00 7
+    python3 tools/haptics_upload.py - 0x80 LRA_AUTOON click 0xF0 5 0x00 7   (print the lines)
+
+mode is a number or LRA_AUTOON, LRA_AUTOOFF, ERM, PIEZO, optionally followed by
++SEGMENTS or +ENVELOPE.  id is 0x80-0xFE (EFFECT_USER up), the ids below
+are the built in effects.  Bytes are decimal or 0x hex.  The port is opened at
+9600 bps, 8N1, raw.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+MODES = {"LRA_AUTOON": 0, "LRA_AUTOOFF": 1, "ERM": 2, "PIEZO": 3}
+FLAGS = {"SEGMENTS": 0x10, "ENVELOPE": 0x20}
+NAMESIZE = 8
+EFFECT_USER = 0x80                                      # first id the store accepts
+NOID = 0xFF
+READY = re.compile(rb"Ready\r\n")
+DONE = re.compile(rb"(Stored|Upload failed|Store full|Usage[^\r]*)\r\n")
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def parse_mode(text):
+    mode = 0
+    for part in text.upper().split("+"):
+        if part in MODES:
+            mode += MODES[part]
+        elif part in FLAGS:
+            mode += FLAGS[part]
+        else:
+            mode += int(part, 0)
+    if not 0 <= mode <= 0xFF:
+        raise ValueError("mode %s out of range" % text)
+    return mode
+
+
+def upload_lines(effect_id, mode, name, data):
+    if not EFFECT_USER <= effect_id < NOID:
+        raise ValueError("id must be 0x%02X-0x%02X, lower ids are built in" % (EFFECT_USER, NOID - 1))
+    if not 1 <= len(data) <= 0xFF:
+        raise ValueError("data must be 1-255 bytes")
+    if any(not 0 <= b <= 0xFF for b in data):
+        raise ValueError("data bytes must be 0-255")
+    if not name or len(name) > NAMESIZE or any(c in " ,\r\n" for c in name):
+        raise ValueError("name must be 1-%d characters without spaces or commas" % NAMESIZE)
+    fields = [effect_id, mode, len(data), crc16(data)]
+    return ("w %s %s\r" % (" ".join(str(f) for f in fields), name),
+            "%s\r" % " ".join(str(b) for b in data))
+
+
+def open_port(path):
+    import termios
+    fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+    attrs = termios.tcgetattr(fd)
+    attrs[0] = 0                                        # iflag
+    attrs[1] = 0                                        # oflag
+    attrs[2] = termios.CS8 | termios.CREAD | termios.CLOCAL
+    attrs[3] = 0                                        # lflag
+    attrs[4] = attrs[5] = termios.B9600
+    attrs[6][termios.VMIN] = 1
+    attrs[6][termios.VTIME] = 0
+    termios.tcsetattr(fd, termios.TCSANOW, attrs)
+    return fd
+
+
+def wait_for(fd, pattern=None):
+    """Read until pattern or an upload result, returns (match, result)."""
+    received = b""
+    while True:
+        received += os.read(fd, 64)
+        match = pattern.search(received) if pattern else None
+        if match:
+            return match, None
+        done = DONE.search(received)
+        if done:
+            return None, done.group(1).decode()
+
+
+def upload(fd, header, data):
+    os.write(fd, header.encode())
+    ready, result = wait_for(fd, READY)
+    if ready:
+        os.write(fd, data.encode())
+        _, result = wait_for(fd)
+    print(result, file=sys.stderr)
+    return 0 if result == "Stored" else 1
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("port", help="serial port of the board, - to print the lines")
+    parser.add_argument("id", type=lambda s: int(s, 0))
+    parser.add_argument("mode")
+    parser.add_argument("name")
+    parser.add_argument("data", nargs="+")
+    args = parser.parse_args()
+
+    try:
+        header, data = upload_lines(args.id, parse_mode(args.mode), args.name,
+                                    [int(b, 0) for b in args.data])
+    except ValueError as err:
+        print("haptics_upload.py: %s" % err, file=sys.stderr)
+        return 2
+
+    if args.port == "-":
+        sys.stdout.write(header + "\n" + data + "\n")
+        return 0
+
+    fd = open_port(args.port)
+    try:
+        return upload(fd, header, data)
+    finally:
+        os.close(fd)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
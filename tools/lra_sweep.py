@@ -0,0 +1,131 @@
+#!/usr/bin/env python3
+"""
+lra_sweep.py - run the LRA resonance sweep (the 'r' command in main.c,
+LraSweep.c) and answer each step with a rating.
+
+Created on: Oct 19, 2026
+Board: DRV2603EVM-CT RevD
+
+The board plays a burst at each frequency and prints "<hz> Hz: ", then waits
+for a decimal rating, larger is stronger.  The rating comes from one of:
+
+    --ask           the user types a score for every burst
+    --model F0 Q    an accelerometer stand-in: the amplitude response of a
+                    resonator at F0 Hz with quality factor Q, 0-1000
+
+The steps are logged as "hz,rating" lines on stdout.  At the end the board
+saves the best frequency in INFOB.
+
+Usage:
+    python3 tools/lra_sweep.py /dev/ttyACM0 --ask
+    python3 tools/lra_sweep.py /dev/ttyACM0 --model 178 12 > sweep.csv
+    python3 tools/lra_sweep.py - --model 178 12      (no board, print the ratings)
+
+The port is opened at 9600 bps, 8N1, raw.
+"""
+
+import argparse
+import math
+import os
+import re
+import sys
+
+LOW_HZ = 145                    # LRASWEEP_LOW_HZ
+HIGH_HZ = 220                   # LRASWEEP_HIGH_HZ
+STEP_HZ = 5                     # LRASWEEP_STEP_HZ
+PROMPT = re.compile(rb"(\d+) Hz: $")
+DONE = re.compile(rb"(Best \d+ Hz, saved|Stopped|Nothing rated)\r\n")
+
+
+def model_rating(hz, f0, q):
+    """Amplitude response of a second order resonator, 1000 at resonance."""
+    r = hz / f0
+    gain = 1.0 / math.sqrt((1.0 - r * r) ** 2 + (r / q) ** 2)
+    return int(round(1000.0 * gain / q))
+
+
+def ask_rating(hz):
+    while True:
+        text = input("%d Hz, rating: " % hz).strip()
+        if text.isdigit():
+            return int(text)
+        if text == "":
+            return None
+
+
+def open_port(path):
+    import termios
+    fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+    attrs = termios.tcgetattr(fd)
+    attrs[0] = 0                                        # iflag
+    attrs[1] = 0                                        # oflag
+    attrs[2] = termios.CS8 | termios.CREAD | termios.CLOCAL
+    attrs[3] = 0                                        # lflag
+    attrs[4] = attrs[5] = termios.B9600
+    attrs[6][termios.VMIN] = 1
+    attrs[6][termios.VTIME] = 0
+    termios.tcsetattr(fd, termios.TCSANOW, attrs)
+    return fd
+
+
+def sweep(fd, rate):
+    os.write(fd, b"r")
+    received = b""
+    while True:
+        received += os.read(fd, 64)
+        done = DONE.search(received)
+        if done:
+            print(done.group(1).decode(), file=sys.stderr)
+            return 0 if done.group(1).startswith(b"Best") else 1
+        prompt = PROMPT.search(received)
+        if not prompt:
+            continue
+        hz = int(prompt.group(1))
+        received = b""
+        rating = rate(hz)
+        if rating is None:
+            os.write(fd, b"\r")                         # no number stops the sweep
+            continue
+        print("%d,%d" % (hz, rating))
+        sys.stdout.flush()
+        os.write(fd, b"%d\r" % rating)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("port", help="serial port of the board, - for none")
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--ask", action="store_true", help="ask for a rating of every burst")
+    source.add_argument("--model", nargs=2, type=float, metavar=("F0", "Q"),
+                        help="rate with a resonator model instead of an accelerometer")
+    args = parser.parse_args()
+
+    if args.model:
+        f0, q = args.model
+        if f0 <= 0 or q <= 0:
+            parser.error("F0 and Q must be > 0")
+        rate = lambda hz: model_rating(hz, f0, q)
+    else:
+        rate = ask_rating
+
+    if args.port == "-":
+        best = None
+        for hz in range(LOW_HZ, HIGH_HZ + 1, STEP_HZ):
+            rating = rate(hz)
+            if rating is None:
+                return 1
+            print("%d,%d" % (hz, rating))
+            if best is None or rating > best[1]:
+                best = (hz, rating)
+        print("Best %d Hz" % best[0], file=sys.stderr)
+        return 0
+
+    fd = open_port(args.port)
+    try:
+        return sweep(fd, rate)
+    finally:
+        os.close(fd)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,541 @@
+#!/usr/bin/env python3
+"""
+structure_gen.py - generate CTS/structure.c and the user configuration section
+of CTS/structure.h from a board description.
+
+Created on: Oct 19, 2026
+Board: DRV2603EVM-CT RevD
+
+structure.c and structure.h must agree on TOTAL_NUMBER_OF_ELEMENTS,
+MAXIMUM_NUMBER_OF_ELEMENTS_PER_SENSOR, every baseOffset and the HAL
+definitions; a mismatch silently overruns baseCnt.  This tool derives all of
+those from one JSON board description (see board_drv2603evm.json), validates
+it, and writes both files together with per-sensor constants and a RAM usage
+report.
+
+Usage:
+    python3 tools/structure_gen.py tools/board_drv2603evm.json
+    python3 tools/structure_gen.py --check tools/board_drv2603evm.json
+
+--check only compares the generated output with the files in CTS/ and exits
+with status 1 when they differ.
+
+Board description:
+    board, device          names used in the generated comments
+    smclk_hz, aclk_hz      clock frequencies, used for the gate times
+    ram.total              device RAM in bytes
+    ram.cts_budget         bytes the CTS layer may use for static data
+    ram_for_flash          allocate the measurement buffer statically
+    reserved_pins          {"Px.y": "use"} pins no element may use
+    elements               [{name, pin, reference, threshold, max_response,
+                             comment}]
+    sensors                [{name, hal, gate_source, gate, elements,
+                             guard}]   guard = list of GUARD_* mode flags
+    guard (optional)       {enabled, element, sensor, hal, gate_source, gate}
+"""
+
+import argparse
+import json
+import os
+import re
+import sys
+
+REPO = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+STRUCTURE_C = os.path.join(REPO, "CTS", "structure.c")
+STRUCTURE_H = os.path.join(REPO, "CTS", "structure.h")
+
+# structure.h is kept in its original encoding
+ENCODING = "latin-1"
+
+# HAL definitions known to CTS_HAL.c, in the order they are listed in
+# structure.h.  Only the ones used by a sensor are enabled.
+HAL_DEFINITIONS = [
+    ("OSCILLATOR DEFINITIONS", [
+        ("RO_COMPAp_TA0_WDTp", 64),
+        ("RO_PINOSC_TA0_WDTp", 65),
+        ("RO_PINOSC_TA0", 66),
+        ("RO_COMPAp_TA1_WDTp", 67),
+        ("RO_COMPB_TA0_WDTA", 68),
+        ("RO_COMPB_TA1_WDTA", 69),
+    ]),
+    ("RC DEFINITIONS", [
+        ("RC_PAIR_TA0", 1),
+    ]),
+    ("FAST RO DEFINITIONS", [
+        ("fRO_PINOSC_TA0_SW", 25),
+        ("fRO_COMPB_TA0_SW", 26),
+        ("fRO_COMPB_TA1_SW", 27),
+        ("fRO_COMPAp_TA0_SW", 28),
+        ("fRO_COMPAp_SW_TA0", 29),
+        ("fRO_COMPAp_TA1_SW", 30),
+    ]),
+]
+
+# The generator only emits PinOsc element fields; other methods need the
+# comparator / RC reference fields which are not described yet.
+SUPPORTED_HALS = {"RO_PINOSC_TA0_WDTp"}
+
+GATE_SOURCES = {"GATE_WDT_SMCLK": "smclk_hz", "GATE_WDT_ACLK": "aclk_hz"}
+WDT_GATES = {
+    "WDTp_GATE_32768": 32768,
+    "WDTp_GATE_8192": 8192,
+    "WDTp_GATE_512": 512,
+    "WDTp_GATE_64": 64,
+}
+GUARD_MODES = ("GUARD_SUBTRACT", "GUARD_GATE")
+
+# Dominant_Element() scales (delta - threshold) by 100/(maxResponse - threshold)
+# in 16 bits, which limits the span to 655 counts.
+MAX_RESPONSE_SPAN = 655
+
+# PinOsc capable ports with a PxSEL2 register
+PINOSC_PORTS = (1, 2, 3)
+
+GENERATED_NOTE = ("// Generated by tools/structure_gen.py from tools/{spec}.\n"
+                  "// Edit the board description and regenerate instead of editing by hand.\n")
+
+STARS = "//" + "*" * 78
+
+
+class SpecError(Exception):
+    pass
+
+
+def parse_pin(pin):
+    m = re.fullmatch(r"P([0-9])\.([0-7])", pin)
+    if not m:
+        raise SpecError("bad pin name '%s', expected Px.y" % pin)
+    return int(m.group(1)), int(m.group(2))
+
+
+class Board:
+    """Validated board description with derived offsets and sequence numbers."""
+
+    def __init__(self, spec, spec_name):
+        self.spec = spec
+        self.spec_name = spec_name
+        self.name = spec.get("board", "")
+        self.device = spec.get("device", "")
+        self.smclk_hz = spec["smclk_hz"]
+        self.aclk_hz = spec["aclk_hz"]
+        self.ram_total = spec["ram"]["total"]
+        self.ram_budget = spec["ram"]["cts_budget"]
+        self.ram_for_flash = spec.get("ram_for_flash", True)
+
+        self.elements = {}
+        for e in spec["elements"]:
+            self._add_element(e)
+
+        self.sensors = []
+        for s in spec["sensors"]:
+            self.sensors.append(self._sensor(s, guarded=True))
+
+        self.guard = None
+        self.guard_enabled = False
+        if "guard" in spec:
+            g = spec["guard"]
+            self.guard_enabled = bool(g.get("enabled", False))
+            element = dict(g["element"])
+            element.setdefault("reference", "0")
+            element.setdefault("comment", "guard")
+            self._add_element(element)
+            self.guard = self._sensor({
+                "name": g["sensor"],
+                "hal": g["hal"],
+                "gate_source": g["gate_source"],
+                "gate": g["gate"],
+                "elements": [element["name"]],
+            }, guarded=False)
+
+        self._validate()
+        self._assign_offsets()
+
+    def _add_element(self, e):
+        name = e["name"]
+        if name in self.elements:
+            raise SpecError("element '%s' defined twice" % name)
+        port, bit = parse_pin(e["pin"])
+        self.elements[name] = {
+            "name": name,
+            "pin": e["pin"],
+            "port": port,
+            "bit": bit,
+            "reference": str(e.get("reference", "0")),
+            "threshold": int(e["threshold"]),
+            "max_response": int(e["max_response"]),
+            "comment": e.get("comment", name),
+            "sensor": None,
+        }
+
+    def _sensor(self, s, guarded):
+        if s["hal"] not in SUPPORTED_HALS:
+            raise SpecError("sensor '%s': HAL %s is not supported by the generator"
+                            % (s["name"], s["hal"]))
+        if s["gate_source"] not in GATE_SOURCES:
+            raise SpecError("sensor '%s': unknown gate source %s" % (s["name"], s["gate_source"]))
+        if s["gate"] not in WDT_GATES:
+            raise SpecError("sensor '%s': unknown gate %s" % (s["name"], s["gate"]))
+        guard = s.get("guard", []) if guarded else []
+        for mode in guard:
+            if mode not in GUARD_MODES:
+                raise SpecError("sensor '%s': unknown guard mode %s" % (s["name"], mode))
+        elements = []
+        for name in s["elements"]:
+            if name not in self.elements:
+                raise SpecError("sensor '%s': unknown element '%s'" % (s["name"], name))
+            e = self.elements[name]
+            if e["sensor"] is not None:
+                raise SpecError("element '%s' is used by sensors '%s' and '%s'"
+                                % (name, e["sensor"], s["name"]))
+            e["sensor"] = s["name"]
+            elements.append(e)
+        if not elements:
+            raise SpecError("sensor '%s' has no elements" % s["name"])
+        clock = getattr(self, GATE_SOURCES[s["gate_source"]])
+        gate_cycles = WDT_GATES[s["gate"]]
+        return {
+            "name": s["name"],
+            "hal": s["hal"],
+            "gate_source": s["gate_source"],
+            "gate": s["gate"],
+            "elements": elements,
+            "guard": guard,
+            "gate_us": (gate_cycles * 1000000 + clock // 2) // clock,
+        }
+
+    def _validate(self):
+        pins = {}
+        reserved = self.spec.get("reserved_pins", {})
+        for e in self.elements.values():
+            if e["sensor"] is None:
+                raise SpecError("element '%s' is not used by any sensor" % e["name"])
+            if e["port"] not in PINOSC_PORTS:
+                raise SpecError("element '%s': P%d has no PinOsc" % (e["name"], e["port"]))
+            if e["pin"] in pins:
+                raise SpecError("elements '%s' and '%s' share pin %s"
+                                % (pins[e["pin"]], e["name"], e["pin"]))
+            if e["pin"] in reserved:
+                raise SpecError("element '%s': pin %s is reserved for %s"
+                                % (e["name"], e["pin"], reserved[e["pin"]]))
+            pins[e["pin"]] = e["name"]
+            if not 0 < e["threshold"] < 0x10000:
+                raise SpecError("element '%s': threshold out of range" % e["name"])
+            if self.guard and e is self.guard["elements"][0]:
+                continue                # the guard only uses its threshold
+            span = e["max_response"] - e["threshold"]
+            if not 0 < span <= MAX_RESPONSE_SPAN:
+                raise SpecError("element '%s': max_response - threshold must be 1..%d, is %d"
+                                % (e["name"], MAX_RESPONSE_SPAN, span))
+        names = [s["name"] for s in self.all_sensors()]
+        if len(set(names)) != len(names):
+            raise SpecError("duplicate sensor names")
+        if len(set(names) & set(self.elements)):
+            raise SpecError("sensor and element names must differ")
+
+    def _assign_offsets(self):
+        offset = 0
+        for s in self.all_sensors():
+            s["base_offset"] = offset
+            for e in s["elements"]:
+                e["sequence"] = offset
+                offset += 1
+
+    def all_sensors(self):
+        return self.sensors + ([self.guard] if self.guard else [])
+
+    def total_elements(self, with_guard):
+        sensors = self.all_sensors() if with_guard else self.sensors
+        return sum(len(s["elements"]) for s in sensors)
+
+    def max_per_sensor(self):
+        return max(len(s["elements"]) for s in self.all_sensors())
+
+    def hals(self):
+        return {s["hal"] for s in self.all_sensors()}
+
+    # -- RAM ------------------------------------------------------------------
+
+    def ram_report(self, with_guard):
+        """List of (item, bytes, static) for the CTS layer and its users."""
+        total = self.total_elements(with_guard)
+        maximum = self.max_per_sensor()
+        items = [
+            ("baseCnt[TOTAL_NUMBER_OF_ELEMENTS]", 2 * total, True),
+            ("ctsStatusReg", 2, True),
+            ("ctsCalibration", 2, True),
+        ]
+        if self.ram_for_flash:
+            items.append(("measCnt[MAXIMUM_NUMBER_OF_ELEMENTS_PER_SENSOR]", 2 * maximum, True))
+        else:
+            items.append(("heap for measCnt", 2 * maximum + 2, True))
+        items.append(("CapTouch_Calibrate() stack", 4 * total + 10 * maximum, False))
+        return items
+
+
+# -- Output -------------------------------------------------------------------
+
+def c_element(board, e):
+    guard = board.guard and e is board.guard["elements"][0]
+    lines = []
+    lines.append("//PinOsc %s %s" % ("Guard" if guard else e["comment"], e["pin"]))
+    lines.append("const struct Element %s = {" % e["name"])
+    lines.append("")
+    lines.append("              .inputPxselRegister = (unsigned char *)&P%dSEL," % e["port"])
+    lines.append("              .inputPxsel2Register = (unsigned char *)&P%dSEL2," % e["port"])
+    lines.append("              .inputBits = BIT%d," % e["bit"])
+    lines.append("              .maxResponse = %d," % e["max_response"])
+    lines.append("              .threshold = %d," % e["threshold"])
+    lines.append("              .referenceNumber = %s," % e["reference"])
+    lines.append("              .sequenceNumber = %d" % e["sequence"])
+    lines.append("};")
+    return lines
+
+
+def c_sensor(board, s):
+    lines = []
+    lines.append("const struct Sensor %s =" % s["name"])
+    lines.append("               { ")
+    lines.append("                  .halDefinition = %s," % s["hal"])
+    lines.append("                  .numElements = %d," % len(s["elements"]))
+    lines.append("                  .baseOffset = %d," % s["base_offset"])
+    lines.append("                  // Pointer to elements")
+    for i, e in enumerate(s["elements"]):
+        lines.append("                  .arrayPtr[%d] = &%s," % (i, e["name"]))
+    lines.append("                  // Timer Information")
+    lines.append("                  .measGateSource= %s," % s["gate_source"])
+    if s is board.guard:
+        lines.append("                  .accumulationCycles= %s," % s["gate"])
+        lines.append("                  .guardSensor = 0")
+    elif board.guard and s["guard"]:
+        lines.append("                  .accumulationCycles= %s," % s["gate"])
+        lines.append("#ifdef GUARD_CHANNEL")
+        lines.append("                  .guardSensor = &%s," % board.guard["name"])
+        lines.append("                  .guardMode = %s" % " + ".join(s["guard"]))
+        lines.append("#endif")
+    else:
+        lines.append("                  .accumulationCycles= %s" % s["gate"])
+    lines.append("               };")
+    return lines
+
+
+def generate_c(board):
+    out = []
+    out.append(STARS)
+    out.append("//  structure.c")
+    out.append("//  %s, %s" % (board.name, board.device))
+    out.append("//  threshold and maxResponse values must be updated for electrode design,")
+    out.append("//  system clock settings, selection of gate measurement source, and ")
+    out.append("//  accumulation cycles.  CapTouch_Calibrate() can override them at run time.")
+    out.append(STARS)
+    out.append(GENERATED_NOTE.format(spec=board.spec_name).rstrip("\n"))
+    out.append("")
+    out.append('#include "structure.h"')
+    out.append('#include "../CapTouchBoard.h"')
+    out.append("")
+    for s in board.sensors:
+        for e in s["elements"]:
+            out.extend(c_element(board, e))
+            out.append("")
+    if board.guard:
+        out.append("#ifdef GUARD_CHANNEL")
+        out.append("// The guard electrode surrounds the buttons and is not touched in normal use.")
+        out.append("// Its threshold is the common-mode shift at which the guarded sensors are")
+        out.append("// gated (see GUARD_GATE).")
+        out.extend(c_element(board, board.guard["elements"][0]))
+        out.append("")
+        out.extend(c_sensor(board, board.guard))
+        out.append("#endif")
+        out.append("")
+    out.append("//*** Sensor   *******************************************************/")
+    out.append("// This defines the grouping of sensors, the method to measure change in")
+    out.append("// capacitance, and the function of the group")
+    out.append("")
+    for s in board.sensors:
+        out.extend(c_sensor(board, s))
+        out.append("")
+    return "\n".join(out)
+
+
+def h_ram_block(board):
+    out = []
+    out.append("//****** RAM USAGE *************************************************************")
+    out.append("// Static RAM of the CTS layer for this board (%d bytes available to the CTS" % board.ram_budget)
+    out.append("// layer, %d bytes total).  Generated, see tools/structure_gen.py." % board.ram_total)
+    variants = [(False, "without guard")]
+    if board.guard:
+        variants.append((True, "with GUARD_CHANNEL"))
+    for with_guard, label in variants:
+        out.append("//   %s:" % label)
+        static = 0
+        for item, size, is_static in board.ram_report(with_guard):
+            out.append("//     %-48s %4d bytes%s" % (item, size, "" if is_static else " (stack)"))
+            if is_static:
+                static += size
+        out.append("//     %-48s %4d bytes" % ("static total", static))
+    return out
+
+
+def h_config(board):
+    total = board.total_elements(False)
+    total_guard = board.total_elements(True)
+    used = board.hals()
+    out = []
+    out.append("")
+    out.append('#include "msp430.h"')
+    out.append("#include <stdint.h>")
+    out.append("")
+    out.append(GENERATED_NOTE.format(spec=board.spec_name).rstrip("\n"))
+    out.append("")
+    out.append("/* Public Globals */")
+    for s in board.sensors:
+        for e in s["elements"]:
+            decl = "extern const struct Element %s;" % e["name"]
+            out.append("%-41s// structure containing elements for %s" % (decl, e["comment"]))
+    out.append("")
+    for s in board.sensors:
+        decl = "extern const struct Sensor %s;" % s["name"]
+        out.append("%-41s// elements %s" % (decl, ", ".join(e["comment"] for e in s["elements"])))
+    out.append("")
+    out.append("//****** GUARD CHANNEL *********************************************************")
+    out.append("// Is a guard (common-mode reference) element used?  A guard element is an ")
+    out.append("// electrode that is not touched in normal use, so any shift in its counts is")
+    out.append("// common to the whole panel (e.g. a water film).  When defined, a Sensor can")
+    out.append("// name a single element guard Sensor and the guard delta is subtracted from,")
+    out.append("// and/or used to gate, the deltas of the Sensor's own elements.  The guard")
+    out.append("// element needs its own entry in TOTAL_NUMBER_OF_ELEMENTS.")
+    if board.guard:
+        out.append("%s#define GUARD_CHANNEL" % ("" if board.guard_enabled else "//"))
+        out.append("")
+        out.append("#ifdef GUARD_CHANNEL")
+        decl = "extern const struct Element %s;" % board.guard["elements"][0]["name"]
+        out.append("%-43s// structure containing guard element" % decl)
+        decl = "extern const struct Sensor %s;" % board.guard["name"]
+        out.append("%-43s// single element guard sensor" % decl)
+        out.append("#endif")
+    else:
+        out.append("//#define GUARD_CHANNEL")
+    out.append("")
+    out.append("//****** RAM ALLOCATION ********************************************************")
+    out.append("// TOTAL_NUMBER_OF_ELEMENTS represents the total number of elements used, even if ")
+    out.append("// they are going to be segmented into seperate groups.  This defines the ")
+    out.append("// RAM allocation for the baseline tracking.  If only the TI_CAPT_Raw function")
+    out.append("// is used, then this definition should be removed to conserve RAM space.")
+    if board.guard:
+        out.append("#ifdef GUARD_CHANNEL")
+        out.append("#define TOTAL_NUMBER_OF_ELEMENTS %d" % total_guard)
+        out.append("#else")
+        out.append("#define TOTAL_NUMBER_OF_ELEMENTS %d" % total)
+        out.append("#endif")
+    else:
+        out.append("#define TOTAL_NUMBER_OF_ELEMENTS %d" % total)
+    out.append("// If the RAM_FOR_FLASH definition is removed, then the appropriate HEAP size ")
+    out.append("// must be allocated. 2 bytes * MAXIMUM_NUMBER_OF_ELEMENTS_PER_SENSOR + 2 bytes")
+    out.append("// of overhead.")
+    out.append("%s#define RAM_FOR_FLASH" % ("" if board.ram_for_flash else "//"))
+    out.append("//****** Structure Array Definition ********************************************")
+    out.append("// This defines the array size in the sensor strucure.  In the event that ")
+    out.append("// RAM_FOR_FLASH is defined, then this also defines the amount of RAM space")
+    out.append("// allocated (global variable) for computations.")
+    out.append("#define MAXIMUM_NUMBER_OF_ELEMENTS_PER_SENSOR  %d" % board.max_per_sensor())
+    out.append("//****** Sensor Constants ******************************************************")
+    out.append("// Per sensor values derived from structure.c.  GATE_US is the measurement")
+    out.append("// time of one element, SCAN_US the time to measure the whole sensor.")
+    for s in board.all_sensors():
+        prefix = s["name"].upper()
+        n = len(s["elements"])
+        if s is board.guard:
+            out.append("#ifdef GUARD_CHANNEL")
+        out.append("#define %-36s %d" % (prefix + "_BASE_OFFSET", s["base_offset"]))
+        out.append("#define %-36s %d" % (prefix + "_NUM_ELEMENTS", n))
+        out.append("#define %-36s %d" % (prefix + "_GATE_US", s["gate_us"]))
+        out.append("#define %-36s %d" % (prefix + "_SCAN_US", s["gate_us"] * n))
+        if s is board.guard:
+            out.append("#endif")
+    out.extend(h_ram_block(board))
+    out.append("//****** Choosing a  Measurement Method ****************************************")
+    out.append("// These variables are references to the definitions found in structure.c and")
+    out.append("// must be generated per the application.")
+    out.append("// possible values for the method field")
+    for title, hals in HAL_DEFINITIONS:
+        out.append("")
+        out.append("// %s" % title)
+        for name, value in hals:
+            out.append("%s#define %-24s%d" % ("" if name in used else "//", name, value))
+    out.append("")
+    out.append("//****** WHEEL and SLIDER ******************************************************")
+    out.append("// Are wheel or slider representations used?")
+    out.append("//#define SLIDER")
+    out.append("//#define ILLEGAL_SLIDER_WHEEL_POSITION		0xFFFF")
+    out.append("//#define WHEEL")
+    out.append("")
+    return "\n".join(out)
+
+
+CONFIG_START = "// The following elements need to be configured by the user.\n" + STARS + "\n"
+CONFIG_END = STARS + "\n// End of user configuration section."
+
+
+def generate_h(board, current):
+    start = current.find(CONFIG_START)
+    end = current.find(CONFIG_END)
+    if start < 0 or end < 0 or end < start:
+        raise SpecError("structure.h: user configuration markers not found")
+    start += len(CONFIG_START)
+    return current[:start] + h_config(board) + "\n" + current[end:]
+
+
+def check_budget(board):
+    for with_guard in ((False, True) if board.guard else (False,)):
+        static = sum(size for _, size, is_static in board.ram_report(with_guard) if is_static)
+        if static > board.ram_budget:
+            raise SpecError("CTS static RAM %d bytes exceeds the budget of %d bytes%s"
+                            % (static, board.ram_budget, " (with guard)" if with_guard else ""))
+
+
+def read(path):
+    with open(path, "r", encoding=ENCODING, newline="") as f:
+        return f.read()
+
+
+def write(path, text):
+    with open(path, "w", encoding=ENCODING, newline="") as f:
+        f.write(text)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("spec", help="board description (JSON)")
+    parser.add_argument("--check", action="store_true",
+                        help="only compare with CTS/structure.c and CTS/structure.h")
+    args = parser.parse_args()
+
+    with open(args.spec) as f:
+        spec = json.load(f)
+    try:
+        board = Board(spec, os.path.basename(args.spec))
+        check_budget(board)
+        current_h = read(STRUCTURE_H)
+        newline = "\r\n" if "\r\n" in current_h else "\n"
+        text_h = generate_h(board, current_h.replace("\r\n", "\n")).replace("\n", newline)
+        text_c = (generate_c(board) + "\n").replace("\n", newline)
+    except (SpecError, KeyError) as err:
+        print("%s: %s" % (args.spec, err), file=sys.stderr)
+        return 2
+
+    for line in h_ram_block(board)[3:]:
+        print(line[2:])
+
+    if args.check:
+        stale = [p for p, t in ((STRUCTURE_C, text_c), (STRUCTURE_H, text_h))
+                 if not os.path.exists(p) or read(p) != t]
+        for path in stale:
+            print("%s is out of date" % os.path.relpath(path, REPO), file=sys.stderr)
+        return 1 if stale else 0
+
+    write(STRUCTURE_C, text_c)
+    write(STRUCTURE_H, text_h)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())